@@ -0,0 +1,58 @@
+#include "heap_stats.h"
+
+#include <cstdlib>
+#include <new>
+
+std::atomic<std::size_t> allocation_count = 0;
+std::atomic<std::size_t> allocated_bytes = 0;
+
+void* operator new(std::size_t size) {
+    ++allocation_count;
+    allocated_bytes += size;
+    if (void* ptr = std::malloc(size == 0 ? 1 : size)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    ++allocation_count;
+    allocated_bytes += size;
+    return std::malloc(size == 0 ? 1 : size);
+}
+
+void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept {
+    std::free(ptr);
+}
+
+// Через эти перегрузки выделяет память std::pmr::new_delete_resource()
+void* operator new(std::size_t size, std::align_val_t align) {
+    ++allocation_count;
+    allocated_bytes += size;
+    const auto alignment = static_cast<std::size_t>(align);
+#ifdef _MSC_VER
+    void* ptr = _aligned_malloc(size == 0 ? 1 : size, alignment);
+#else
+    void* ptr = std::aligned_alloc(alignment, ((size == 0 ? 1 : size) + alignment - 1) / alignment * alignment);
+#endif
+    if (ptr) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr, std::align_val_t) noexcept {
+#ifdef _MSC_VER
+    _aligned_free(ptr);
+#else
+    std::free(ptr);
+#endif
+}
+
+void operator delete(void* ptr, std::size_t, std::align_val_t align) noexcept {
+    operator delete(ptr, align);
+}
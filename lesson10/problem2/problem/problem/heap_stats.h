@@ -0,0 +1,11 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+
+// Счётчики обращений к глобальной куче для замеров числа аллокаций и объёма
+// памяти. Их ведут замены глобальных operator new и delete из heap_stats.cpp:
+// в отдельной единице трансляции компилятор не встраивает их в места вызова
+// и не путает пары new/delete с malloc/free.
+extern std::atomic<std::size_t> allocation_count;
+extern std::atomic<std::size_t> allocated_bytes;
@@ -1,7 +1,12 @@
 #include "json.h"
+#include "json_parser.h"
+#include "json_writer.h"
 #include <sstream>
 #include <iomanip>
+#include <bit>
 #include <cctype>
+#include <unordered_map>
+#include <unordered_set>
 
 using namespace std;
 
@@ -9,357 +14,254 @@ namespace json {
 
 namespace {
 
-Node LoadNode(istream& input);
-
-using Number = variant<int, double>;
-
-Number LoadNumber(istream& input) {
-    using namespace std::literals;
-
-    string parsed_num;
-
-    auto read_char = [&parsed_num, &input] {
-        parsed_num += static_cast<char>(input.get());
-        if (!input) {
-            throw ParsingError("Failed to read number from stream"s);
-        }
-    };
-
-    auto read_digits = [&input, read_char] {
-        if (!isdigit(input.peek())) {
-            throw ParsingError("A digit is expected"s);
-        }
-        while (isdigit(input.peek())) {
-            read_char();
-        }
-    };
-
-    if (input.peek() == '-') {
-        read_char();
-    }
-
-    if (input.peek() == '0') {
-        read_char();
-    } else {
-        read_digits();
-    }
-
-    bool is_int = true;
-    if (input.peek() == '.') {
-        read_char();
-        read_digits();
-        is_int = false;
-    }
-
-    if (int ch = input.peek(); ch == 'e' || ch == 'E') {
-        read_char();
-        if (ch = input.peek(); ch == '+' || ch == '-') {
-            read_char();
-        }
-        read_digits();
-        is_int = false;
-    }
-
-    try {
-        if (is_int) {
-            try {
-                return stoi(parsed_num);
-            } catch (...) {}
-        }
-        return stod(parsed_num);
-    } catch (...) {
-        throw ParsingError("Failed to convert "s + parsed_num + " to number"s);
-    }
+// Финальное перемешивание splitmix64: близкие значения дают далёкие хэши
+uint64_t Mix(uint64_t value) {
+    value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    value = (value ^ (value >> 27)) * 0x94d049bb133111ebULL;
+    return value ^ (value >> 31);
 }
 
-string LoadString(istream& input) {
-    using namespace std::literals;
+uint64_t Combine(uint64_t seed, uint64_t value) {
+    return Mix(seed + 0x9e3779b97f4a7c15ULL + value);
+}
 
-    // Считываем открывающую кавычку
-    char quote;
-    input >> quote;
-    if (quote != '"') {
-        throw ParsingError("String should start with quote");
-    }
+Node CompactNode(const Node& node, detail::SubtreeTable& subtrees);
 
-    auto it = istreambuf_iterator<char>(input);
-    auto end = istreambuf_iterator<char>();
-    string s;
-    while (true) {
-        if (it == end) {
-            throw ParsingError("String parsing error");
+// Копия узла, в которой вложенные контейнеры заменены общими
+Node RebuildNode(const Node& node, detail::SubtreeTable& subtrees) {
+    if (node.IsArray()) {
+        const Array& array = node.AsArray();
+        Array result;
+        result.reserve(array.size());
+        for (const Node& item : array) {
+            result.push_back(CompactNode(item, subtrees));
         }
-        const char ch = *it;
-        if (ch == '"') {
-            ++it;
-            break;
-        } else if (ch == '\\') {
-            ++it;
-            if (it == end) {
-                throw ParsingError("String parsing error");
-            }
-            const char escaped_char = *(it);
-            switch (escaped_char) {
-            case 'n': s.push_back('\n'); break;
-            case 't': s.push_back('\t'); break;
-            case 'r': s.push_back('\r'); break;
-            case '"': s.push_back('"'); break;
-            case '\\': s.push_back('\\'); break;
-            default: throw ParsingError("Unrecognized escape sequence \\"s + escaped_char);
-            }
-        } else if (ch == '\n' || ch == '\r') {
-            throw ParsingError("Unexpected end of line"s);
-        } else {
-            s.push_back(ch);
+        return result;
+    }
+    if (node.IsMap()) {
+        const Dict& dict = node.AsMap();
+        Dict result;
+        result.reserve(dict.size());
+        for (const auto& [key, item] : dict) {
+            result.try_emplace(key, CompactNode(item, subtrees));
         }
-        ++it;
+        return result;
     }
-
-    return s;
+    return node;
 }
 
-Node LoadNull(istream& input) {
-    string word;
-    for (int i = 0; i < 4; ++i) {
-        word += static_cast<char>(input.get());
+Node CompactNode(const Node& node, detail::SubtreeTable& subtrees) {
+    // Повторное поддерево не перестраивается
+    if (const Node* found = subtrees.Find(node)) {
+        return *found;
     }
-    if (word != "null") {
-        throw ParsingError("Invalid null value: " + word);
-    }
-    return Node(nullptr);
+    return subtrees.Intern(RebuildNode(node, subtrees));
 }
 
-Node LoadBool(istream& input) {
-    string word;
-    char c = static_cast<char>(input.get());
-    word += c;
-
-    if (c == 't') {
-        for (int i = 0; i < 3; ++i) {
-            c = static_cast<char>(input.get());
-            word += c;
+// Оценка памяти в куче, которую занимает поддерево. Общие поддеревья
+// учитываются один раз; seen хранит адреса уже учтённых.
+size_t HeapBytes(const Node& node, unordered_set<const void*>& seen) {
+    size_t bytes = 0;
+    if (node.IsShared()) {
+        const void* target = node.IsArray() ? static_cast<const void*>(&node.AsArray())
+                                            : static_cast<const void*>(&node.AsMap());
+        if (!seen.insert(target).second) {
+            return 0;
         }
-        if (word != "true") {
-            throw ParsingError("Invalid boolean value: " + word);
+        // Блок общего узла: счётчик ссылок и сам узел
+        bytes += sizeof(Node) + sizeof(size_t);
+    }
+    if (node.IsArray()) {
+        const Array& array = node.AsArray();
+        // Блок массива: сам вектор и кэш хэша
+        bytes += sizeof(Array) + sizeof(size_t) + array.capacity() * sizeof(Node);
+        for (const Node& item : array) {
+            bytes += HeapBytes(item, seen);
         }
-        return Node(true);
-    } else {
-        for (int i = 0; i < 4; ++i) {
-            c = static_cast<char>(input.get());
-            word += c;
+    } else if (node.IsMap()) {
+        const Dict& dict = node.AsMap();
+        bytes += sizeof(Dict) + sizeof(size_t) + dict.size() * sizeof(Dict::value_type);
+        for (const auto& [key, item] : dict) {
+            bytes += HeapBytes(item, seen);
         }
-        if (word != "false") {
-            throw ParsingError("Invalid boolean value: " + word);
+    } else if (node.IsString() && !node.IsBorrowedString()) {
+        // Короткая строка хранится в самом узле
+        const size_t size = node.AsString().size();
+        if (size > Node::kInlineStringCapacity) {
+            bytes += sizeof(size_t) + size;
         }
-        return Node(false);
-    }
-}
-
-void SkipWhitespace(istream& input) {
-    while (isspace(input.peek())) {
-        input.get();
     }
+    return bytes;
 }
 
-Node LoadArray(istream& input) {
-    Array result;
-    char c;
-    input >> c; // read '['
+}  // namespace
 
-    SkipWhitespace(input);
-    if (input.peek() == ']') {
-        input.get();
-        return Node(move(result));
+Node Node::Share(Node node) {
+    if (node.IsShared()) {
+        return node;
     }
-
-    while (true) {
-        result.push_back(LoadNode(input));
-        SkipWhitespace(input);
-        input >> c;
-        if (c == ']') {
-            break;
-        } else if (c != ',') {
-            throw ParsingError("Expected ',' or ']' in array");
-        }
-        SkipWhitespace(input);
+    // Общее поддерево может пережить арену своего документа, поэтому
+    // контейнер из арены копируется в кучу вместе со всем содержимым
+    const pmr::memory_resource* heap = pmr::get_default_resource();
+    SharedBlock* block;
+    if ((node.IsArray() && node.AsArray().get_allocator().resource() != heap)
+        || (node.IsMap() && node.AsMap().get_allocator().resource() != heap)) {
+        block = new SharedBlock{{1}, static_cast<const Node&>(node)};
+    } else {
+        block = new SharedBlock{{1}, move(node)};
     }
-
-    return Node(move(result));
+    Node result;
+    result.Store(block);
+    result.kind_ = Kind::Shared;
+    return result;
 }
 
-Node LoadDict(istream& input) {
-    Dict result;
-    char c;
-    input >> c; // read '{'
-
-    SkipWhitespace(input);
-    if (input.peek() == '}') {
-        input.get();
-        return Node(move(result));
+Node Node::Persist(Node node) {
+    if (node.IsShared()) {
+        return node;
     }
-
-    while (true) {
-        if (input.peek() != '"') {
-            throw ParsingError("Dictionary key must be string");
+    // Сначала вложенные контейнеры: копия общего контейнера из арены
+    // тогда копирует только ссылки на них
+    if (node.IsArray()) {
+        for (Node& item : node.MutableArrayInPlace()) {
+            item = Persist(move(item));
         }
-        string key = LoadString(input); // Теперь LoadString сама читает кавычки
-
-        SkipWhitespace(input);
-        input >> c;
-        if (c != ':') {
-            throw ParsingError("Expected ':' after dictionary key");
-        }
-
-        result[move(key)] = LoadNode(input);
-
-        SkipWhitespace(input);
-        input >> c;
-        if (c == '}') {
-            break;
-        } else if (c != ',') {
-            throw ParsingError("Expected ',' or '}' in dictionary");
+    } else if (node.IsMap()) {
+        for (auto& [key, item] : node.MutableMapInPlace()) {
+            item = Persist(move(item));
         }
-        SkipWhitespace(input);
+    } else {
+        return node;
     }
-
-    return Node(move(result));
+    return Share(move(node));
 }
 
-Node LoadNode(istream& input) {
-    SkipWhitespace(input);
-    char c = static_cast<char>(input.peek());
-
-    if (c == '[') {
-        return LoadArray(input);
-    } else if (c == '{') {
-        return LoadDict(input);
-    } else if (c == '"') {
-        return Node(LoadString(input));
-    } else if (c == 'n') {
-        auto node = LoadNull(input);
-        // Проверяем, что после ключевого слова идет разделитель
-        SkipWhitespace(input);
-        if (isalnum(input.peek())) {
-            throw ParsingError("Invalid value after null");
-        }
-        return node;
-    } else if (c == 't' || c == 'f') {
-        auto node = LoadBool(input);
-        // Проверяем, что после ключевого слова идет разделитель
-        SkipWhitespace(input);
-        if (isalnum(input.peek())) {
-            throw ParsingError("Invalid value after boolean");
+size_t Node::ComputeHash() const {
+    // Тип входит в хэш, чтобы [], {}, null и 0 различались. Своя и
+    // заимствованная строки хэшируются одинаково, как и сравниваются.
+    uint64_t hash = Mix(static_cast<uint64_t>(GetType()));
+    switch (kind_) {
+    case Kind::Null:
+        break;
+    case Kind::Bool:
+        hash = Combine(hash, Load<bool>() ? 1 : 0);
+        break;
+    case Kind::Int:
+        hash = Combine(hash, static_cast<uint64_t>(Load<int>()));
+        break;
+    case Kind::Int64:
+    case Kind::Uint64:
+        hash = Combine(hash, Load<uint64_t>());
+        break;
+    case Kind::Double: {
+        // -0.0 == 0.0, значит и хэш у них общий
+        const double number = Load<double>();
+        hash = Combine(hash, bit_cast<uint64_t>(number == 0.0 ? 0.0 : number));
+        break;
+    }
+    case Kind::Array:
+        for (const Node& item : AsArray()) {
+            hash = Combine(hash, item.Hash());
         }
-        return node;
-    } else if (isdigit(c) || c == '-') {
-        auto number = LoadNumber(input);
-        if (holds_alternative<int>(number)) {
-            return Node(get<int>(number));
-        } else {
-            return Node(get<double>(number));
+        break;
+    case Kind::Dict:
+        for (const auto& [key, item] : AsMap()) {
+            hash = Combine(Combine(hash, std::hash<string_view>{}(key.View())), item.Hash());
         }
-    } else {
-        throw ParsingError("Unexpected character: " + string(1, c));
+        break;
+    default:
+        hash = Combine(hash, std::hash<string_view>{}(AsString()));
+        break;
     }
+    return hash != 0 ? static_cast<size_t>(hash) : 1;
 }
 
-// Print functions
-struct PrintContext {
-    ostream& out;
-    int indent_step = 4;
-    int indent = 0;
-
-    void PrintIndent() const {
-        for (int i = 0; i < indent; ++i) {
-            out.put(' ');
-        }
-    }
-
-    PrintContext Indented() const {
-        return {out, indent_step, indent + indent_step};
-    }
-};
-
-template <typename Value>
-void PrintValue(const Value& value, const PrintContext& ctx) {
-    ctx.out << value;
+Document Load(string_view input, const LoadOptions& options) {
+    // Первый блок арены соразмерен входу, дальше она растёт геометрически
+    return detail::LoadDocument(input, options, max<size_t>(input.size(), 4096));
 }
 
-void PrintValue(nullptr_t, const PrintContext& ctx) {
-    ctx.out << "null";
+Document LoadBuffer(string input, const LoadOptions& options) {
+    const size_t arena_size = max<size_t>(input.size(), 4096);
+    auto owner = make_shared<const string>(move(input));
+    const string_view text = *owner;
+    return detail::LoadOwnedBuffer(text, move(owner), options, arena_size);
 }
 
-void PrintValue(bool value, const PrintContext& ctx) {
-    ctx.out << (value ? "true" : "false");
+Document Load(istream& input, const LoadOptions& options) {
+    // Поток разбирается блоками, не накапливаясь в памяти целиком
+    return detail::LoadDocument(input, options, size_t{1} << 16);
 }
 
-void PrintValue(const string& value, const PrintContext& ctx) {
-    ctx.out << '"';
-    for (char c : value) {
-        switch (c) {
-        case '\n': ctx.out << "\\n"; break;
-        case '\r': ctx.out << "\\r"; break;
-        case '\t': ctx.out << "\\t"; break;
-        case '"': ctx.out << "\\\""; break;
-        case '\\': ctx.out << "\\\\"; break;
-        default: ctx.out << c;
+// Заменяет заимствованные строки своими копиями. Общее поддерево
+// перестраивается один раз, и все его вхождения получают одну замену.
+void Document::OwnStrings(Node& node, unordered_map<const void*, Node>& rebuilt) {
+    if (node.IsShared()) {
+        const void* target = node.IsArray() ? static_cast<const void*>(&node.AsArray())
+                                            : static_cast<const void*>(&node.AsMap());
+        if (const auto it = rebuilt.find(target); it != rebuilt.end()) {
+            node = it->second;
+            return;
         }
-    }
-    ctx.out << '"';
-}
-
-void PrintNode(const Node& node, const PrintContext& ctx) {
-    visit([&ctx](const auto& value) {
-        PrintValue(value, ctx);
-    }, node.GetValue());
-}
-
-void PrintValue(const Array& array, const PrintContext& ctx) {
-    ctx.out << "[\n";
-    bool first = true;
-    PrintContext indented_ctx = ctx.Indented();
-    for (const auto& item : array) {
-        if (!first) {
-            ctx.out << ",\n";
+        Node copy = node;
+        copy.Unshare();
+        OwnStrings(copy, rebuilt);
+        node = rebuilt.emplace(target, Node::Share(move(copy))).first->second;
+    } else if (node.IsArray()) {
+        for (Node& item : node.MutableArrayInPlace()) {
+            OwnStrings(item, rebuilt);
+        }
+    } else if (node.IsMap()) {
+        for (auto& [key, item] : node.MutableMapInPlace()) {
+            OwnStrings(item, rebuilt);
         }
-        first = false;
-        indented_ctx.PrintIndent();
-        PrintNode(item, indented_ctx);
+    } else if (node.IsBorrowedString()) {
+        node = Node{string(node.AsString())};
     }
-    ctx.out << '\n';
-    ctx.PrintIndent();
-    ctx.out << ']';
 }
 
-void PrintValue(const Dict& dict, const PrintContext& ctx) {
-    ctx.out << "{\n";
-    bool first = true;
-    PrintContext indented_ctx = ctx.Indented();
-    for (const auto& [key, value] : dict) {
-        if (!first) {
-            ctx.out << ",\n";
-        }
-        first = false;
-        indented_ctx.PrintIndent();
-        PrintValue(key, indented_ctx);
-        ctx.out << ": ";
-        PrintNode(value, indented_ctx);
+Node Document::ExtractRoot() && {
+    // Копия контейнера из арены размещается в куче
+    Node root = HasArena() ? Node(static_cast<const Node&>(root_)) : std::move(root_);
+    if (OwnsInput()) {
+        unordered_map<const void*, Node> rebuilt;
+        OwnStrings(root, rebuilt);
     }
-    ctx.out << '\n';
-    ctx.PrintIndent();
-    ctx.out << '}';
+    Reset();
+    return root;
 }
 
+size_t Compact(Document& doc) {
+    unordered_set<const void*> seen;
+    const size_t before = HeapBytes(doc.root_, seen);
+    detail::SubtreeTable subtrees;
+    // Новое дерево строится в куче, поэтому старое можно разрушить вместе с ареной
+    Node root = RebuildNode(doc.root_, subtrees);
+    doc.root_ = std::move(root);
+    doc.arena_.reset();
+    seen.clear();
+    const size_t after = HeapBytes(doc.root_, seen);
+    return before > after ? before - after : 0;
+}
 
-}  // namespace
-
-Document Load(istream& input) {
-    return Document{LoadNode(input)};
+void Persist(Document& doc) {
+    // Общие контейнеры размещаются в куче, поэтому старое дерево можно
+    // разрушить вместе с ареной
+    Node root = Node::Persist(std::move(doc.root_));
+    doc.root_ = std::move(root);
+    doc.arena_.reset();
 }
 
 void Print(const Document& doc, ostream& output) {
-    PrintContext ctx{output};
-    PrintNode(doc.GetRoot(), ctx);
+    Writer writer(output);
+    writer.Write(doc.GetRoot());
+}
+
+void PrintCompact(const Document& doc, ostream& output) {
+    WriterOptions options;
+    options.compact = true;
+    Writer writer(output, options);
+    writer.Write(doc.GetRoot());
 }
 
 }  // namespace json
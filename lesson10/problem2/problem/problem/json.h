@@ -1,91 +1,657 @@
 #pragma once
 
+#include "json_dict.h"
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <functional>
 #include <iostream>
-#include <map>
+#include <memory>
+#include <memory_resource>
+#include <new>
 #include <string>
-#include <variant>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
 namespace json {
 
 class Node;
-using Dict = std::map<std::string, Node>;
-using Array = std::vector<Node>;
+// Контейнеры используют polymorphic_allocator: документ, загруженный
+// в арену, размещает в ней все свои массивы и словари. Копия такого
+// контейнера всегда создаётся в ресурсе по умолчанию (в обычной куче).
+using Dict = detail::SortedVectorMap<Node>;
+using Array = std::pmr::vector<Node>;
 
 class ParsingError : public std::runtime_error {
 public:
     using runtime_error::runtime_error;
 };
 
+// Узел занимает 16 байт: 14 байт данных, длина короткой строки и вид
+// значения. Число, bool и null хранятся в самом узле, как и строка
+// до kInlineStringCapacity символов. Массив, словарь и длинная строка
+// вынесены в отдельный блок, на который указывает узел, поэтому размер
+// элемента массива не зависит от самого большого вида значения.
 class Node {
 public:
-    using Value = std::variant<std::nullptr_t, Array, Dict, bool, int, double, std::string>;
-
-    Node() : value_(nullptr) {}
-    Node(std::nullptr_t) : value_(nullptr) {}
-    Node(bool value) : value_(value) {}
-    Node(int value) : value_(value) {}
-    Node(double value) : value_(value) {}
-    Node(std::string value) : value_(std::move(value)) {}
-    Node(const char* value) : value_(std::string(value)) {}
-    Node(Array array) : value_(std::move(array)) {}
-    Node(Dict map) : value_(std::move(map)) {}
-
-    bool IsNull() const { return std::holds_alternative<std::nullptr_t>(value_); }
-    bool IsBool() const { return std::holds_alternative<bool>(value_); }
-    bool IsInt() const { return std::holds_alternative<int>(value_); }
-    bool IsDouble() const { return std::holds_alternative<int>(value_) || std::holds_alternative<double>(value_); }
-    bool IsPureDouble() const { return std::holds_alternative<double>(value_); }
-    bool IsString() const { return std::holds_alternative<std::string>(value_); }
-    bool IsArray() const { return std::holds_alternative<Array>(value_); }
-    bool IsMap() const { return std::holds_alternative<Dict>(value_); }
+    // Целые, не помещающиеся в int, хранятся как Int64, а положительные
+    // сверх INT64_MAX — как Uint64, чтобы не терять точность в double.
+    enum class Type : uint8_t { Null, Bool, Int, Int64, Uint64, Double, String, Array, Dict };
+
+    static constexpr size_t kInlineStringCapacity = 14;
+
+    Node() noexcept = default;
+    Node(std::nullptr_t) noexcept {}
+    Node(bool value) noexcept : kind_(Kind::Bool) { Store(value); }
+    Node(int value) noexcept : kind_(Kind::Int) { Store(value); }
+    Node(int64_t value) noexcept : kind_(Kind::Int64) { Store(value); }
+    Node(uint64_t value) noexcept : kind_(Kind::Uint64) { Store(value); }
+    Node(double value) noexcept : kind_(Kind::Double) { Store(value); }
+    Node(const std::string& value) { InitString(value); }
+    Node(const char* value) { InitString(value); }
+    Node(Array array);
+    Node(Dict map);
+
+    // Копия массива или словаря размещается в ресурсе по умолчанию и
+    // получает вычисленный хэш оригинала. Копия общего узла делит с ним поддерево.
+    Node(const Node& other);
+    Node(Node&& other) noexcept {
+        std::memcpy(data_, other.data_, sizeof(data_));
+        small_size_ = other.small_size_;
+        kind_ = std::exchange(other.kind_, Kind::Null);
+    }
+    Node& operator=(const Node& other) {
+        if (this != &other) {
+            Node copy(other);
+            Swap(copy);
+        }
+        return *this;
+    }
+    Node& operator=(Node&& other) noexcept {
+        if (this != &other) {
+            Node moved(std::move(other));
+            Swap(moved);
+        }
+        return *this;
+    }
+    ~Node() {
+        if (kind_ >= Kind::HeapString) {
+            Release();
+        }
+    }
+
+    // Строка без копирования. Буфер text должен пережить узел и все его копии.
+    static Node BorrowString(std::string_view text) {
+        Node node;
+        // Длина заимствованной строки хранится в 32 битах
+        if (text.size() > UINT32_MAX) {
+            node.InitString(text);
+            return node;
+        }
+        const auto size = static_cast<uint32_t>(text.size());
+        node.Store(text.data());
+        std::memcpy(node.data_ + sizeof(const char*), &size, sizeof(size));
+        node.kind_ = Kind::BorrowedString;
+        return node;
+    }
+
+    // Узел, разделяющий значение node со всеми своими копиями: копирование
+    // такого узла не копирует поддерево. Значение остаётся неизменным.
+    static Node Share(Node node);
+
+    // Постоянное дерево: каждый массив и словарь становится общим (Share).
+    // Копия такого узла стоит O(1), а правка через AsMutable* отделяет
+    // только путь от корня до изменённого узла: каждый контейнер на нём
+    // копируется поверхностно, а остальные поддеревья остаются общими
+    // с оригиналом. Уже общие поддеревья не обходятся, поэтому повторный
+    // вызов после правки обходит только изменённый путь.
+    static Node Persist(Node node);
+
+    // Делает значение узла собственным: общее поддерево копируется,
+    // если его разделяют другие узлы, и забирается без копирования,
+    // если этот узел — единственный владелец
+    void Unshare();
+
+    Type GetType() const;
+
+    bool IsShared() const { return kind_ == Kind::Shared; }
+    bool IsNull() const { return Target().kind_ == Kind::Null; }
+    bool IsBool() const { return Target().kind_ == Kind::Bool; }
+    bool IsInt() const { return Target().kind_ == Kind::Int; }
+    // Целое, представимое в int64_t
+    bool IsInt64() const {
+        const Node& target = Target();
+        if (target.kind_ == Kind::Uint64) {
+            return target.Load<uint64_t>() <= static_cast<uint64_t>(INT64_MAX);
+        }
+        return target.kind_ == Kind::Int || target.kind_ == Kind::Int64;
+    }
+    // Неотрицательное целое, представимое в uint64_t
+    bool IsUint64() const {
+        const Node& target = Target();
+        switch (target.kind_) {
+        case Kind::Int:
+            return target.Load<int>() >= 0;
+        case Kind::Int64:
+            return target.Load<int64_t>() >= 0;
+        default:
+            return target.kind_ == Kind::Uint64;
+        }
+    }
+    bool IsDouble() const {
+        const Kind kind = Target().kind_;
+        return kind >= Kind::Int && kind <= Kind::Double;
+    }
+    bool IsPureDouble() const { return Target().kind_ == Kind::Double; }
+    bool IsString() const {
+        const Kind kind = Target().kind_;
+        return kind >= Kind::SmallString && kind <= Kind::HeapString;
+    }
+    bool IsBorrowedString() const { return Target().kind_ == Kind::BorrowedString; }
+    bool IsArray() const { return Target().kind_ == Kind::Array; }
+    bool IsMap() const { return Target().kind_ == Kind::Dict; }
 
     bool AsBool() const {
         if (!IsBool()) throw std::logic_error("Not a bool");
-        return std::get<bool>(value_);
+        return Target().Load<bool>();
     }
 
     int AsInt() const {
         if (!IsInt()) throw std::logic_error("Not an int");
-        return std::get<int>(value_);
+        return Target().Load<int>();
     }
 
-    double AsDouble() const {
-        if (!IsDouble()) throw std::logic_error("Not a double");
-        if (auto int_val = std::get_if<int>(&value_)) {
-            return static_cast<double>(*int_val);
+    int64_t AsInt64() const {
+        if (!IsInt64()) throw std::logic_error("Not an int64");
+        const Node& target = Target();
+        if (target.kind_ == Kind::Int) {
+            return target.Load<int>();
         }
-        return std::get<double>(value_);
+        return target.Load<int64_t>();
     }
 
-    const std::string& AsString() const {
-        if (!IsString()) throw std::logic_error("Not a string");
-        return std::get<std::string>(value_);
+    uint64_t AsUint64() const {
+        if (!IsUint64()) throw std::logic_error("Not an uint64");
+        const Node& target = Target();
+        if (target.kind_ == Kind::Int) {
+            return static_cast<uint64_t>(target.Load<int>());
+        }
+        return target.Load<uint64_t>();
     }
 
-    const Array& AsArray() const {
-        if (!IsArray()) throw std::logic_error("Not an array");
-        return std::get<Array>(value_);
+    double AsDouble() const {
+        const Node& target = Target();
+        switch (target.kind_) {
+        case Kind::Int:
+            return static_cast<double>(target.Load<int>());
+        case Kind::Int64:
+            return static_cast<double>(target.Load<int64_t>());
+        case Kind::Uint64:
+            return static_cast<double>(target.Load<uint64_t>());
+        case Kind::Double:
+            return target.Load<double>();
+        default:
+            throw std::logic_error("Not a double");
+        }
     }
 
-    const Dict& AsMap() const {
-        if (!IsMap()) throw std::logic_error("Not a map");
-        return std::get<Dict>(value_);
-    }
+    std::string_view AsString() const;
+    const Array& AsArray() const&;
+    const Dict& AsMap() const&;
+    // Контейнер временного узла забирается, а не копируется
+    Array AsArray() && { return TakeArray(); }
+    Dict AsMap() && { return TakeMap(); }
 
-    bool operator==(const Node& other) const { return value_ == other.value_; }
-    bool operator!=(const Node& other) const { return !(*this == other); }
+    // Доступ для изменения на месте. Общее поддерево сначала
+    // отделяется (Unshare). Ссылка может жить и меняться сколько угодно
+    // долго, поэтому хэш такого контейнера больше не кэшируется. Путь
+    // от корня к нему проходит через AsMutable* родителей, так что и их
+    // хэши вычисляются заново и не устаревают. Копия узла кэширует хэш снова.
+    //
+    // Контейнер документа из арены выделяет новые элементы в той же
+    // арене: перемещённые из него узлы нельзя уносить за пределы документа.
+    Array& AsMutableArray();
+    Dict& AsMutableMap();
 
-    const Value& GetValue() const { return value_; }
+    // Забирают контейнер без копирования и оставляют узел null
+    Array TakeArray();
+    Dict TakeMap();
+
+    // Структурный хэш: равные узлы имеют равный хэш. Для массивов
+    // и словарей вычисляется при первом обращении и запоминается,
+    // в том числе у всех вложенных контейнеров, кроме выданных через
+    // AsMutable*. Можно вызывать из нескольких потоков одновременно.
+    size_t Hash() const;
+
+    // Своя и заимствованная строки равны, если совпадает текст.
+    // Деревья с уже вычисленными и различными хэшами отвергаются без обхода,
+    // а узлы, разделяющие одно поддерево, равны без обхода.
+    bool operator==(const Node& other) const;
+    bool operator!=(const Node& other) const { return !(*this == other); }
 
 private:
-    Value value_;
+    friend class Document;
+
+    // Виды, начиная с HeapString, владеют отдельным блоком
+    enum class Kind : uint8_t {
+        Null,
+        Bool,
+        Int,
+        Int64,
+        Uint64,
+        Double,
+        SmallString,
+        BorrowedString,
+        HeapString,
+        Array,
+        Dict,
+        Shared,
+    };
+
+    // Блоки вынесенных значений. Кэш хэша контейнера: 0 — ещё не вычислен.
+    // Контейнер меняется только по ссылке из AsMutable*, после которой
+    // кэш не используется (lent), поэтому он не устаревает.
+    struct StringBlock;
+    struct ArrayBlock;
+    struct DictBlock;
+    struct SharedBlock;
+
+    template <typename T>
+    T Load() const noexcept {
+        T value;
+        std::memcpy(&value, data_, sizeof(T));
+        return value;
+    }
+    template <typename T>
+    void Store(T value) noexcept {
+        std::memcpy(data_, &value, sizeof(T));
+    }
+
+    void InitString(std::string_view text);
+    void Release() noexcept;
+    void Swap(Node& other) noexcept {
+        char data[sizeof(data_)];
+        std::memcpy(data, data_, sizeof(data_));
+        std::memcpy(data_, other.data_, sizeof(data_));
+        std::memcpy(other.data_, data, sizeof(data_));
+        std::swap(small_size_, other.small_size_);
+        std::swap(kind_, other.kind_);
+    }
+
+    // Узел, который хранит значение: сам узел либо разделяемое поддерево
+    const Node& Target() const;
+    // Кэш хэша контейнера или nullptr для остальных видов
+    // и для контейнеров, выданных для изменения
+    std::atomic<size_t>* HashCache() const;
+    // Изменяемый контейнер для внутренних обходов, не меняющих хэш
+    // и не сохраняющих ссылку: кэш остаётся в силе
+    Array& MutableArrayInPlace();
+    Dict& MutableMapInPlace();
+
+    // Никогда не возвращает 0
+    size_t ComputeHash() const;
+
+    // Число или указатель на блок в первых 8 байтах; у заимствованной
+    // строки за указателем следует 32-битная длина
+    alignas(8) char data_[kInlineStringCapacity] = {};
+    uint8_t small_size_ = 0;
+    Kind kind_ = Kind::Null;
+};
+
+static_assert(sizeof(Node) == 16);
+
+// За заголовком блока следуют символы строки
+struct Node::StringBlock {
+    size_t size;
 };
 
+struct Node::ArrayBlock {
+    Array array;
+    mutable std::atomic<size_t> hash{0};
+    // Ссылка на массив выдана через AsMutableArray
+    bool lent = false;
+};
+
+struct Node::DictBlock {
+    Dict dict;
+    mutable std::atomic<size_t> hash{0};
+    // Ссылка на словарь выдана через AsMutableMap
+    bool lent = false;
+};
+
+// Узел блока не меняется, пока его разделяют несколько владельцев
+struct Node::SharedBlock {
+    std::atomic<size_t> refs;
+    Node node;
+};
+
+// Блок контейнера выделяется из того же ресурса, что и его элементы:
+// контейнер документа из арены целиком лежит в арене
+inline Node::Node(Array array) : kind_(Kind::Array) {
+    std::pmr::memory_resource* resource = array.get_allocator().resource();
+    void* memory = resource->allocate(sizeof(ArrayBlock), alignof(ArrayBlock));
+    Store(new (memory) ArrayBlock{std::move(array)});
+}
+
+inline Node::Node(Dict map) : kind_(Kind::Dict) {
+    std::pmr::memory_resource* resource = map.get_allocator().resource();
+    void* memory = resource->allocate(sizeof(DictBlock), alignof(DictBlock));
+    Store(new (memory) DictBlock{std::move(map)});
+}
+
+inline Node::Node(const Node& other) {
+    switch (other.kind_) {
+    case Kind::HeapString:
+        InitString(other.AsString());
+        break;
+    case Kind::Array: {
+        const ArrayBlock* block = other.Load<ArrayBlock*>();
+        Node copy{Array(block->array)};
+        copy.Load<ArrayBlock*>()->hash.store(block->hash.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        Swap(copy);
+        break;
+    }
+    case Kind::Dict: {
+        const DictBlock* block = other.Load<DictBlock*>();
+        Node copy{Dict(block->dict)};
+        copy.Load<DictBlock*>()->hash.store(block->hash.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        Swap(copy);
+        break;
+    }
+    case Kind::Shared:
+        other.Load<SharedBlock*>()->refs.fetch_add(1, std::memory_order_relaxed);
+        [[fallthrough]];
+    default:
+        std::memcpy(data_, other.data_, sizeof(data_));
+        small_size_ = other.small_size_;
+        kind_ = other.kind_;
+    }
+}
+
+inline void Node::InitString(std::string_view text) {
+    if (text.size() <= kInlineStringCapacity) {
+        std::memcpy(data_, text.data(), text.size());
+        small_size_ = static_cast<uint8_t>(text.size());
+        kind_ = Kind::SmallString;
+        return;
+    }
+    void* memory = ::operator new(sizeof(StringBlock) + text.size());
+    StringBlock* block = new (memory) StringBlock{text.size()};
+    std::memcpy(reinterpret_cast<char*>(block + 1), text.data(), text.size());
+    Store(block);
+    kind_ = Kind::HeapString;
+}
+
+inline void Node::Release() noexcept {
+    switch (kind_) {
+    case Kind::HeapString:
+        ::operator delete(Load<StringBlock*>());
+        break;
+    case Kind::Array: {
+        ArrayBlock* block = Load<ArrayBlock*>();
+        std::pmr::memory_resource* resource = block->array.get_allocator().resource();
+        block->~ArrayBlock();
+        resource->deallocate(block, sizeof(ArrayBlock), alignof(ArrayBlock));
+        break;
+    }
+    case Kind::Dict: {
+        DictBlock* block = Load<DictBlock*>();
+        std::pmr::memory_resource* resource = block->dict.get_allocator().resource();
+        block->~DictBlock();
+        resource->deallocate(block, sizeof(DictBlock), alignof(DictBlock));
+        break;
+    }
+    case Kind::Shared: {
+        SharedBlock* block = Load<SharedBlock*>();
+        if (block->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            delete block;
+        }
+        break;
+    }
+    default:
+        break;
+    }
+    kind_ = Kind::Null;
+}
+
+inline const Node& Node::Target() const {
+    if (kind_ == Kind::Shared) {
+        return Load<SharedBlock*>()->node;
+    }
+    return *this;
+}
+
+inline std::atomic<size_t>* Node::HashCache() const {
+    switch (kind_) {
+    case Kind::Array: {
+        ArrayBlock* block = Load<ArrayBlock*>();
+        return block->lent ? nullptr : &block->hash;
+    }
+    case Kind::Dict: {
+        DictBlock* block = Load<DictBlock*>();
+        return block->lent ? nullptr : &block->hash;
+    }
+    default:
+        return nullptr;
+    }
+}
+
+inline Node::Type Node::GetType() const {
+    switch (Target().kind_) {
+    case Kind::Null:
+        return Type::Null;
+    case Kind::Bool:
+        return Type::Bool;
+    case Kind::Int:
+        return Type::Int;
+    case Kind::Int64:
+        return Type::Int64;
+    case Kind::Uint64:
+        return Type::Uint64;
+    case Kind::Double:
+        return Type::Double;
+    case Kind::Array:
+        return Type::Array;
+    case Kind::Dict:
+        return Type::Dict;
+    default:
+        return Type::String;
+    }
+}
+
+inline std::string_view Node::AsString() const {
+    const Node& target = Target();
+    switch (target.kind_) {
+    case Kind::SmallString:
+        return {target.data_, target.small_size_};
+    case Kind::BorrowedString: {
+        uint32_t size;
+        std::memcpy(&size, target.data_ + sizeof(const char*), sizeof(size));
+        return {target.Load<const char*>(), size};
+    }
+    case Kind::HeapString: {
+        const StringBlock* block = target.Load<StringBlock*>();
+        return {reinterpret_cast<const char*>(block + 1), block->size};
+    }
+    default:
+        throw std::logic_error("Not a string");
+    }
+}
+
+inline const Array& Node::AsArray() const& {
+    if (!IsArray()) throw std::logic_error("Not an array");
+    return Target().Load<ArrayBlock*>()->array;
+}
+
+inline const Dict& Node::AsMap() const& {
+    if (!IsMap()) throw std::logic_error("Not a map");
+    return Target().Load<DictBlock*>()->dict;
+}
+
+inline void Node::Unshare() {
+    if (kind_ != Kind::Shared) {
+        return;
+    }
+    SharedBlock* block = Load<SharedBlock*>();
+    Node target = block->refs.load(std::memory_order_acquire) == 1 ? std::move(block->node) : Node(block->node);
+    *this = std::move(target);
+}
+
+inline Array& Node::AsMutableArray() {
+    if (!IsArray()) throw std::logic_error("Not an array");
+    Unshare();
+    ArrayBlock* block = Load<ArrayBlock*>();
+    block->hash.store(0, std::memory_order_relaxed);
+    block->lent = true;
+    return block->array;
+}
+
+inline Dict& Node::AsMutableMap() {
+    if (!IsMap()) throw std::logic_error("Not a map");
+    Unshare();
+    DictBlock* block = Load<DictBlock*>();
+    block->hash.store(0, std::memory_order_relaxed);
+    block->lent = true;
+    return block->dict;
+}
+
+inline Array& Node::MutableArrayInPlace() {
+    Unshare();
+    return Load<ArrayBlock*>()->array;
+}
+
+inline Dict& Node::MutableMapInPlace() {
+    Unshare();
+    return Load<DictBlock*>()->dict;
+}
+
+inline Array Node::TakeArray() {
+    Array array = std::move(AsMutableArray());
+    Release();
+    return array;
+}
+
+inline Dict Node::TakeMap() {
+    Dict dict = std::move(AsMutableMap());
+    Release();
+    return dict;
+}
+
+inline size_t Node::Hash() const {
+    const Node& target = Target();
+    std::atomic<size_t>* cache = target.HashCache();
+    if (cache == nullptr) {
+        return target.ComputeHash();
+    }
+    size_t hash = cache->load(std::memory_order_relaxed);
+    if (hash == 0) {
+        hash = target.ComputeHash();
+        cache->store(hash, std::memory_order_relaxed);
+    }
+    return hash;
+}
+
+inline bool Node::operator==(const Node& other) const {
+    const Node& lhs = Target();
+    const Node& rhs = other.Target();
+    if (lhs.IsString() && rhs.IsString()) {
+        return lhs.AsString() == rhs.AsString();
+    }
+    if (lhs.kind_ != rhs.kind_) {
+        return false;
+    }
+    switch (lhs.kind_) {
+    case Kind::Null:
+        return true;
+    case Kind::Bool:
+        return lhs.Load<bool>() == rhs.Load<bool>();
+    case Kind::Int:
+        return lhs.Load<int>() == rhs.Load<int>();
+    case Kind::Int64:
+        return lhs.Load<int64_t>() == rhs.Load<int64_t>();
+    case Kind::Uint64:
+        return lhs.Load<uint64_t>() == rhs.Load<uint64_t>();
+    case Kind::Double:
+        return lhs.Load<double>() == rhs.Load<double>();
+    default:
+        break;
+    }
+    if (lhs.Load<const void*>() == rhs.Load<const void*>()) {
+        return true;
+    }
+    const std::atomic<size_t>* cache = lhs.HashCache();
+    const std::atomic<size_t>* other_cache = rhs.HashCache();
+    if (cache != nullptr && other_cache != nullptr) {
+        const size_t hash = cache->load(std::memory_order_relaxed);
+        const size_t other_hash = other_cache->load(std::memory_order_relaxed);
+        if (hash != 0 && other_hash != 0 && hash != other_hash) {
+            return false;
+        }
+    }
+    if (lhs.kind_ == Kind::Array) {
+        return lhs.AsArray() == rhs.AsArray();
+    }
+    return lhs.AsMap() == rhs.AsMap();
+}
+
 class Document {
 public:
+    using Arena = std::pmr::monotonic_buffer_resource;
+
     explicit Document(Node root) : root_(std::move(root)) {}
+    // Документ становится владельцем арены, из которой выделены контейнеры root,
+    // и входного буфера, на который ссылаются заимствованные строки root.
+    // Буфер может быть любым объектом: строкой, отображённым файлом и т. п.
+    Document(Node root, std::unique_ptr<Arena> arena, std::shared_ptr<const void> input = nullptr)
+        : input_(std::move(input))
+        , arena_(std::move(arena))
+        , root_(std::move(root)) {
+    }
+
+    // Копия не зависит от арены оригинала и размещается в обычной куче,
+    // но разделяет с ним входной буфер. Общие поддеревья не копируются,
+    // поэтому копия постоянного документа (Persist) стоит O(1).
+    Document(const Document& other)
+        : input_(other.input_)
+        , root_(other.root_) {
+    }
+    Document(Document&&) = default;
+
+    Document& operator=(const Document& other) {
+        if (this != &other) {
+            Node root = other.root_;
+            std::shared_ptr<const void> input = other.input_;
+            Reset();
+            input_ = std::move(input);
+            root_ = std::move(root);
+        }
+        return *this;
+    }
+
+    Document& operator=(Document&& other) noexcept {
+        if (this != &other) {
+            Reset();
+            input_ = std::move(other.input_);
+            arena_ = std::move(other.arena_);
+            root_ = std::move(other.root_);
+        }
+        return *this;
+    }
+
     const Node& GetRoot() const { return root_; }
+    // Корень для изменения на месте; см. Node::AsMutableArray
+    Node& GetRoot() { return root_; }
+    // Забирает дерево, оставляя документ пустым. Дерево без арены
+    // и без заимствованных строк отдаётся без копирования. Дерево
+    // из арены копируется в кучу, а заимствованные строки заменяются
+    // своими копиями: результат не зависит от документа.
+    Node ExtractRoot() &&;
+    bool HasArena() const { return arena_ != nullptr; }
+    // Документ владеет буфером, на который ссылаются его строки
+    bool OwnsInput() const { return input_ != nullptr; }
 
     bool operator==(const Document& other) const {
         return root_ == other.root_;
@@ -96,10 +662,69 @@ public:
     }
 
 private:
+    friend size_t Compact(Document& doc);
+    friend void Persist(Document& doc);
+
+    // Заменяет заимствованные строки своими копиями
+    static void OwnStrings(Node& node, std::unordered_map<const void*, Node>& rebuilt);
+
+    // Старое дерево должно быть разрушено, пока живы его арена и буфер
+    void Reset() noexcept {
+        root_ = nullptr;
+        arena_.reset();
+        input_.reset();
+    }
+
+    // Буфер и арена объявлены раньше корня, поэтому освобождаются после него
+    std::shared_ptr<const void> input_;
+    std::unique_ptr<Arena> arena_;
     Node root_;
 };
 
-Document Load(std::istream& input);
+struct LoadOptions {
+    // Размещать массивы и словари документа в монотонной арене: загрузка
+    // сводится к сдвигу указателя, а память освобождается одним блоком
+    bool use_arena = false;
+    // Строки без экранирования ссылаются на входной буфер, а не копируются.
+    // Для Load(string_view) буфер должен пережить документ и все копии
+    // его узлов. LoadBuffer и загрузка из файла держат буфер, пока жив
+    // документ или его копия, но не отдельные узлы: узел, скопированный
+    // из такого документа, действителен, только пока жив документ.
+    bool borrow_strings = false;
+    // Одинаковые непустые массивы и словари хранятся один раз и разделяются
+    // всеми местами, где встречаются (Node::Share). Арена при этом не
+    // используется: общее поддерево может пережить документ.
+    bool deduplicate = false;
+};
+
+Document Load(std::istream& input, const LoadOptions& options = {});
+Document Load(std::string_view input, const LoadOptions& options = {});
+// С borrow_strings документ забирает input во владение, и его строки без
+// экранирования ссылаются на этот буфер. Копии документа разделяют буфер
+// с оригиналом, а узлы, скопированные из документа, — нет.
+Document LoadBuffer(std::string input, const LoadOptions& options = {});
 void Print(const Document& doc, std::ostream& output);
+// Вывод в одну строку без пробелов между токенами
+void PrintCompact(const Document& doc, std::ostream& output);
+
+// Заменяет одинаковые непустые массивы и словари документа общими
+// поддеревьями, как LoadOptions::deduplicate. Документ из арены переносится
+// в кучу, и арена освобождается. Возвращает оценку освобождённой памяти в байтах.
+size_t Compact(Document& doc);
+
+// Делает дерево документа постоянным (Node::Persist): копии документа
+// разделяют его целиком, и правка копии не затрагивает оригинал. Документ
+// из арены переносится в кучу, и арена освобождается. После правок
+// повторный вызов снова делает копирование документа O(1).
+void Persist(Document& doc);
 
 }  // namespace json
+
+namespace std {
+
+template <>
+struct hash<json::Node> {
+    size_t operator()(const json::Node& node) const { return node.Hash(); }
+};
+
+}  // namespace std
@@ -0,0 +1,315 @@
+#include "json_binary.h"
+#include "json_file.h"
+#include "json_parser.h"
+
+#include <algorithm>
+#include <bit>
+#include <climits>
+#include <cstring>
+#include <iterator>
+#include <memory>
+#include <ostream>
+#include <string>
+
+using namespace std;
+
+namespace json {
+
+namespace {
+
+constexpr string_view kMagic = "JSNB"sv;
+constexpr char kVersion = 1;
+
+enum Tag : unsigned char {
+    kNull = 0x00,
+    kFalse = 0x01,
+    kTrue = 0x02,
+    kInt = 0x03,
+    kInt64 = 0x04,
+    kUint64 = 0x05,
+    kDouble = 0x06,
+    kString = 0x07,
+    kArray = 0x08,
+    kDict = 0x09,
+};
+
+uint64_t ZigZag(int64_t value) {
+    return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+}
+
+int64_t UnZigZag(uint64_t value) {
+    return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+// Копит закодированные данные в буфере и сбрасывает их в поток блоками
+class BinaryEncoder {
+public:
+    explicit BinaryEncoder(ostream& output)
+        : output_(output) {
+        buffer_.reserve(kBufferSize + kMaxScalarSize);
+    }
+
+    ~BinaryEncoder() {
+        Flush();
+    }
+
+    void Write(const Node& node) {
+        switch (node.GetType()) {
+        case Node::Type::Null:
+            Put(kNull);
+            break;
+        case Node::Type::Bool:
+            Put(node.AsBool() ? kTrue : kFalse);
+            break;
+        case Node::Type::Int:
+            Put(kInt);
+            PutVarint(ZigZag(node.AsInt()));
+            break;
+        case Node::Type::Int64:
+            Put(kInt64);
+            PutVarint(ZigZag(node.AsInt64()));
+            break;
+        case Node::Type::Uint64:
+            Put(kUint64);
+            PutVarint(node.AsUint64());
+            break;
+        case Node::Type::Double: {
+            Put(kDouble);
+            const uint64_t bits = bit_cast<uint64_t>(node.AsDouble());
+            for (int shift = 0; shift < 64; shift += 8) {
+                Put(static_cast<char>(bits >> shift));
+            }
+            break;
+        }
+        case Node::Type::String:
+            Put(kString);
+            PutBytes(node.AsString());
+            break;
+        case Node::Type::Array: {
+            const Array& array = node.AsArray();
+            Put(kArray);
+            PutVarint(array.size());
+            for (const Node& item : array) {
+                Write(item);
+            }
+            break;
+        }
+        case Node::Type::Dict: {
+            const Dict& dict = node.AsMap();
+            Put(kDict);
+            PutVarint(dict.size());
+            for (const auto& [key, item] : dict) {
+                PutBytes(key.View());
+                Write(item);
+            }
+            break;
+        }
+        }
+        if (buffer_.size() >= kBufferSize) {
+            Flush();
+        }
+    }
+
+    void PutRaw(string_view bytes) {
+        buffer_.append(bytes);
+    }
+
+    void Flush() {
+        output_.write(buffer_.data(), static_cast<streamsize>(buffer_.size()));
+        buffer_.clear();
+    }
+
+private:
+    static constexpr size_t kBufferSize = size_t{1} << 16;
+    // Тег, varint и double помещаются с запасом
+    static constexpr size_t kMaxScalarSize = 16;
+
+    void Put(char c) {
+        buffer_.push_back(c);
+    }
+
+    void PutVarint(uint64_t value) {
+        while (value >= 0x80) {
+            buffer_.push_back(static_cast<char>(value | 0x80));
+            value >>= 7;
+        }
+        buffer_.push_back(static_cast<char>(value));
+    }
+
+    void PutBytes(string_view bytes) {
+        PutVarint(bytes.size());
+        if (buffer_.size() + bytes.size() > kBufferSize) {
+            Flush();
+            if (bytes.size() > kBufferSize) {
+                output_.write(bytes.data(), static_cast<streamsize>(bytes.size()));
+                return;
+            }
+        }
+        buffer_.append(bytes);
+    }
+
+    ostream& output_;
+    string buffer_;
+};
+
+// Разбирает значения из непрерывного буфера. Размер каждого контейнера
+// известен заранее, поэтому память под элементы выделяется один раз.
+class BinaryDecoder {
+public:
+    BinaryDecoder(string_view input, pmr::memory_resource* resource, bool borrow_strings)
+        : pos_(input.data())
+        , end_(input.data() + input.size())
+        , resource_(resource)
+        , borrow_strings_(borrow_strings) {
+    }
+
+    void ReadHeader() {
+        if (static_cast<size_t>(end_ - pos_) < kMagic.size() + 1 || string_view(pos_, kMagic.size()) != kMagic) {
+            throw ParsingError("Not a binary JSON document");
+        }
+        pos_ += kMagic.size();
+        if (*pos_++ != kVersion) {
+            throw ParsingError("Unsupported binary JSON version");
+        }
+    }
+
+    Node ReadValue() {
+        switch (static_cast<unsigned char>(ReadByte())) {
+        case kNull:
+            return Node{};
+        case kFalse:
+            return Node{false};
+        case kTrue:
+            return Node{true};
+        case kInt: {
+            const int64_t value = UnZigZag(ReadVarint());
+            if (value < INT_MIN || value > INT_MAX) {
+                throw ParsingError("Binary int out of range");
+            }
+            return Node{static_cast<int>(value)};
+        }
+        case kInt64:
+            return Node{UnZigZag(ReadVarint())};
+        case kUint64:
+            return Node{ReadVarint()};
+        case kDouble: {
+            const string_view bytes = ReadBytes(8);
+            uint64_t bits = 0;
+            for (int i = 0; i < 8; ++i) {
+                bits |= static_cast<uint64_t>(static_cast<unsigned char>(bytes[i])) << (8 * i);
+            }
+            return Node{bit_cast<double>(bits)};
+        }
+        case kString: {
+            const string_view text = ReadBytes(ReadVarint());
+            return borrow_strings_ ? Node::BorrowString(text) : Node{string(text)};
+        }
+        case kArray: {
+            const uint64_t size = ReadVarint();
+            Array array(resource_);
+            // Каждый элемент занимает хотя бы байт: повреждённый размер не раздует память
+            array.reserve(static_cast<size_t>(min<uint64_t>(size, Remaining())));
+            for (uint64_t i = 0; i < size; ++i) {
+                array.push_back(ReadValue());
+            }
+            return Node{move(array)};
+        }
+        case kDict: {
+            const uint64_t size = ReadVarint();
+            Dict dict(resource_);
+            dict.reserve(static_cast<size_t>(min<uint64_t>(size, Remaining())));
+            for (uint64_t i = 0; i < size; ++i) {
+                Symbol key = keys_.Intern(ReadBytes(ReadVarint()));
+                dict.try_emplace(move(key), ReadValue());
+            }
+            return Node{move(dict)};
+        }
+        default:
+            throw ParsingError("Unknown binary JSON tag");
+        }
+    }
+
+private:
+    size_t Remaining() const {
+        return static_cast<size_t>(end_ - pos_);
+    }
+
+    char ReadByte() {
+        if (pos_ == end_) {
+            throw ParsingError("Unexpected end of binary JSON");
+        }
+        return *pos_++;
+    }
+
+    uint64_t ReadVarint() {
+        uint64_t value = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            const auto byte = static_cast<unsigned char>(ReadByte());
+            value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+            if ((byte & 0x80) == 0) {
+                return value;
+            }
+        }
+        throw ParsingError("Binary JSON varint is too long");
+    }
+
+    string_view ReadBytes(uint64_t size) {
+        if (size > Remaining()) {
+            throw ParsingError("Unexpected end of binary JSON");
+        }
+        const string_view bytes(pos_, static_cast<size_t>(size));
+        pos_ += size;
+        return bytes;
+    }
+
+    const char* pos_;
+    const char* end_;
+    pmr::memory_resource* resource_;
+    bool borrow_strings_;
+    detail::KeyTable keys_;
+};
+
+Document DecodeDocument(string_view input, const LoadOptions& options, shared_ptr<const void> owner) {
+    // Двоичное представление компактнее текста, так что арена берётся с запасом
+    unique_ptr<Document::Arena> arena = detail::MakeArena(options, max<size_t>(input.size() * 2, 4096));
+    BinaryDecoder decoder(input, arena ? arena.get() : pmr::get_default_resource(), options.borrow_strings);
+    decoder.ReadHeader();
+    Node root = decoder.ReadValue();
+    // Буфер нужен документу, только если строки ссылаются на него
+    if (!options.borrow_strings) {
+        owner.reset();
+    }
+    Document doc{move(root), move(arena), move(owner)};
+    if (options.deduplicate) {
+        Compact(doc);
+    }
+    return doc;
+}
+
+}  // namespace
+
+void SaveBinary(const Document& doc, ostream& output) {
+    BinaryEncoder encoder(output);
+    encoder.PutRaw(kMagic);
+    encoder.PutRaw(string_view(&kVersion, 1));
+    encoder.Write(doc.GetRoot());
+}
+
+Document LoadBinary(string_view input, const LoadOptions& options) {
+    return DecodeDocument(input, options, nullptr);
+}
+
+Document LoadBinary(istream& input, const LoadOptions& options) {
+    // С borrow_strings документ владеет прочитанным буфером, и строки не копируются
+    auto owner = make_shared<const string>(istreambuf_iterator<char>(input), istreambuf_iterator<char>());
+    const string_view text = *owner;
+    return DecodeDocument(text, options, move(owner));
+}
+
+Document LoadBinaryFile(const filesystem::path& path, const LoadOptions& options) {
+    auto file = make_shared<const MappedFile>(path);
+    const string_view text = file->GetText();
+    return DecodeDocument(text, options, move(file));
+}
+
+}  // namespace json
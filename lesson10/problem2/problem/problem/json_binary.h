@@ -0,0 +1,42 @@
+#pragma once
+
+#include "json.h"
+
+#include <filesystem>
+#include <iosfwd>
+#include <string_view>
+
+namespace json {
+
+// Двоичный формат документа для быстрой повторной загрузки.
+//
+// Файл начинается с заголовка "JSNB" и байта версии (1), за которым идёт
+// одно значение. Значение — байт тега и данные:
+//   0x00 null, 0x01 false, 0x02 true — без данных;
+//   0x03 int, 0x04 int64 — varint от zigzag-кодированного числа;
+//   0x05 uint64          — varint;
+//   0x06 double          — 8 байт IEEE 754, младший байт первым;
+//   0x07 строка          — varint длины и байты UTF-8;
+//   0x08 массив          — varint числа элементов и сами элементы;
+//   0x09 словарь         — varint числа пар, затем пары: varint длины
+//                          ключа, байты ключа и значение. Ключи идут
+//                          по возрастанию, как в Dict.
+// Varint — 7 бит на байт, младшие группы первыми, старший бит байта
+// означает продолжение (как в protobuf и LEB128).
+//
+// Тип числа сохраняется точно, поэтому загруженный документ равен
+// сохранённому по operator==.
+void SaveBinary(const Document& doc, std::ostream& output);
+
+// Выбрасывают ParsingError, если данные повреждены или обрезаны.
+// borrow_strings, как и для Load(string_view), требует, чтобы input
+// пережил документ.
+Document LoadBinary(std::string_view input, const LoadOptions& options = {});
+// С borrow_strings строки ссылаются на прочитанный буфер, как у LoadBuffer:
+// его держат документ и его копии, но не узлы, скопированные из документа
+Document LoadBinary(std::istream& input, const LoadOptions& options = {});
+// Отображает файл в память. С borrow_strings строки ссылаются на отображение,
+// как у LoadFile, иначе копируются, и отображение закрывается после разбора.
+Document LoadBinaryFile(const std::filesystem::path& path, const LoadOptions& options = {});
+
+}  // namespace json
@@ -0,0 +1,145 @@
+#include "json_builder.h"
+
+#include <stdexcept>
+
+using namespace std;
+
+namespace json {
+
+namespace {
+
+#ifdef NDEBUG
+constexpr bool kCheckCalls = false;
+#else
+constexpr bool kCheckCalls = true;
+#endif
+
+}  // namespace
+
+Builder::Builder(ostream& output, const WriterOptions& options)
+    : writer_(output, options) {
+}
+
+Builder& Builder::StartDict() {
+    BeforeValue();
+    if constexpr (kCheckCalls) {
+        stack_.push_back(Context::Dict);
+    }
+    writer_.StartObject();
+    return *this;
+}
+
+Builder& Builder::Key(string_view key) {
+    if constexpr (kCheckCalls) {
+        if (stack_.empty() || stack_.back() != Context::Dict) {
+            throw logic_error("Key outside of a dict or before the previous key's value");
+        }
+        stack_.back() = Context::DictValue;
+    }
+    writer_.Key(key);
+    return *this;
+}
+
+Builder& Builder::EndDict() {
+    CheckEnd(Context::Dict, "EndDict without a matching StartDict");
+    writer_.EndObject();
+    return *this;
+}
+
+Builder& Builder::StartArray() {
+    BeforeValue();
+    if constexpr (kCheckCalls) {
+        stack_.push_back(Context::Array);
+    }
+    writer_.StartArray();
+    return *this;
+}
+
+Builder& Builder::EndArray() {
+    CheckEnd(Context::Array, "EndArray without a matching StartArray");
+    writer_.EndArray();
+    return *this;
+}
+
+Builder& Builder::Value(nullptr_t) {
+    BeforeValue();
+    writer_.Null();
+    return *this;
+}
+
+Builder& Builder::Value(bool value) {
+    BeforeValue();
+    writer_.Bool(value);
+    return *this;
+}
+
+Builder& Builder::Value(int value) {
+    BeforeValue();
+    writer_.Int(value);
+    return *this;
+}
+
+Builder& Builder::Value(int64_t value) {
+    BeforeValue();
+    writer_.Int64(value);
+    return *this;
+}
+
+Builder& Builder::Value(uint64_t value) {
+    BeforeValue();
+    writer_.Uint64(value);
+    return *this;
+}
+
+Builder& Builder::Value(double value) {
+    BeforeValue();
+    writer_.Double(value);
+    return *this;
+}
+
+Builder& Builder::Value(string_view value) {
+    BeforeValue();
+    writer_.String(value);
+    return *this;
+}
+
+Builder& Builder::Value(const Node& node) {
+    BeforeValue();
+    writer_.Write(node);
+    return *this;
+}
+
+void Builder::Finish() {
+    if constexpr (kCheckCalls) {
+        if (!has_root_ || !stack_.empty()) {
+            throw logic_error("JSON value is not complete");
+        }
+    }
+    writer_.Flush();
+}
+
+void Builder::BeforeValue() {
+    if constexpr (kCheckCalls) {
+        if (stack_.empty()) {
+            if (has_root_) {
+                throw logic_error("JSON value is already complete");
+            }
+            has_root_ = true;
+        } else if (stack_.back() == Context::Dict) {
+            throw logic_error("Dict value without a key");
+        } else if (stack_.back() == Context::DictValue) {
+            stack_.back() = Context::Dict;
+        }
+    }
+}
+
+void Builder::CheckEnd(Context context, const char* error) {
+    if constexpr (kCheckCalls) {
+        if (stack_.empty() || stack_.back() != context) {
+            throw logic_error(error);
+        }
+        stack_.pop_back();
+    }
+}
+
+}  // namespace json
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "json.h"
+#include "json_writer.h"
+
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace json {
+
+// Потоковое построение JSON: каждый вызов сразу пишется в поток через Writer,
+// дерево Node не создаётся, и память расходуется пропорционально глубине
+// вложенности. Вызовы объединяются в цепочку:
+//     builder.StartDict().Key("int"sv).Value(42).EndDict().Finish();
+// Правильность последовательности вызовов проверяется только в отладочной
+// сборке (без NDEBUG): нарушение приводит к std::logic_error.
+class Builder {
+public:
+    explicit Builder(std::ostream& output, const WriterOptions& options = {});
+
+    Builder& StartDict();
+    Builder& Key(std::string_view key);
+    Builder& EndDict();
+
+    Builder& StartArray();
+    Builder& EndArray();
+
+    Builder& Value(std::nullptr_t);
+    Builder& Value(bool value);
+    Builder& Value(int value);
+    Builder& Value(int64_t value);
+    Builder& Value(uint64_t value);
+    Builder& Value(double value);
+    Builder& Value(std::string_view value);
+    Builder& Value(const std::string& value) { return Value(std::string_view(value)); }
+    Builder& Value(const char* value) { return Value(std::string_view(value)); }
+    // Готовое поддерево записывается целиком
+    Builder& Value(const Node& node);
+
+    // Проверяет, что значение завершено, и сбрасывает буфер в поток
+    void Finish();
+
+private:
+    enum class Context : uint8_t { Array, Dict, DictValue };
+
+    void BeforeValue();
+    void CheckEnd(Context context, const char* error);
+
+    Writer writer_;
+    // Открытые контейнеры; ведутся только в отладочной сборке
+    std::vector<Context> stack_;
+    bool has_root_ = false;
+};
+
+}  // namespace json
@@ -0,0 +1,222 @@
+#pragma once
+
+#include "json_key.h"
+
+#include <algorithm>
+#include <initializer_list>
+#include <memory_resource>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace json::detail {
+
+// Словарь поверх упорядоченного по ключу вектора пар. Порядок обхода
+// и семантика at/find/operator[] те же, что у std::map<std::string, Mapped>,
+// но элементы лежат в памяти подряд: поиск — двоичный по непрерывному
+// массиву, а словарь из n ключей занимает одно выделение вместо n узлов.
+// Вставка в середину стоит O(n), поэтому ключи, идущие по возрастанию
+// (как в выводе Print), дописываются в конец за O(1), а словарь из ключей
+// в произвольном порядке строится целиком через FromUnordered.
+//
+// Ключи хранятся как Symbol. Ключ элемента менять нельзя: это нарушит
+// упорядоченность.
+template <typename Mapped>
+class SortedVectorMap {
+public:
+    using key_type = Symbol;
+    using mapped_type = Mapped;
+    using value_type = std::pair<Symbol, Mapped>;
+    using allocator_type = std::pmr::polymorphic_allocator<value_type>;
+    using size_type = size_t;
+    using iterator = typename std::pmr::vector<value_type>::iterator;
+    using const_iterator = typename std::pmr::vector<value_type>::const_iterator;
+
+    SortedVectorMap() = default;
+    explicit SortedVectorMap(const allocator_type& allocator)
+        : items_(allocator) {
+    }
+    // Как и у std::map, из повторяющихся ключей остаётся первый
+    SortedVectorMap(std::initializer_list<value_type> items, const allocator_type& allocator = {})
+        : items_(allocator) {
+        items_.reserve(items.size());
+        for (const value_type& item : items) {
+            try_emplace(item.first, item.second);
+        }
+    }
+
+    // Словарь из пар в произвольном порядке: вектор сортируется один раз,
+    // а из повторяющихся ключей остаётся последний, как при insert_or_assign
+    // подряд. Память вектора переходит словарю.
+    static SortedVectorMap FromUnordered(std::pmr::vector<value_type> items) {
+        const auto less = [](const value_type& lhs, const value_type& rhs) {
+            return std::string_view(lhs.first) < std::string_view(rhs.first);
+        };
+        if (!std::is_sorted(items.begin(), items.end(), less)) {
+            std::stable_sort(items.begin(), items.end(), less);
+        }
+        // Из серии равных ключей стабильная сортировка оставляет последним
+        // значение, встретившееся во входе последним
+        size_t kept = 0;
+        for (size_t i = 0; i < items.size(); ++i) {
+            if (i + 1 < items.size() && items[i].first == items[i + 1].first) {
+                continue;
+            }
+            if (kept != i) {
+                items[kept] = std::move(items[i]);
+            }
+            ++kept;
+        }
+        items.erase(items.begin() + static_cast<ptrdiff_t>(kept), items.end());
+        SortedVectorMap result(items.get_allocator());
+        result.items_ = std::move(items);
+        return result;
+    }
+
+    allocator_type get_allocator() const { return items_.get_allocator(); }
+
+    iterator begin() { return items_.begin(); }
+    iterator end() { return items_.end(); }
+    const_iterator begin() const { return items_.begin(); }
+    const_iterator end() const { return items_.end(); }
+
+    size_t size() const { return items_.size(); }
+    bool empty() const { return items_.empty(); }
+    void reserve(size_t capacity) { items_.reserve(capacity); }
+    void clear() { items_.clear(); }
+
+    iterator find(std::string_view key) {
+        if (items_.size() <= kLinearSearchLimit) {
+            // В маленьком словаре быстрее сравнить ключи подряд:
+            // большинство отсеивается по длине
+            return std::find_if(items_.begin(), items_.end(), [key](const value_type& item) {
+                return std::string_view(item.first) == key;
+            });
+        }
+        const iterator it = LowerBound(key);
+        return it != end() && it->first == key ? it : end();
+    }
+    const_iterator find(std::string_view key) const {
+        return const_cast<SortedVectorMap&>(*this).find(key);
+    }
+    // Сначала проверяет позицию, где ключ был найден в прошлый раз
+    iterator find(const Key& key) {
+        const size_t slot = key.slot_.load(std::memory_order_relaxed);
+        if (slot < items_.size() && items_[slot].first == key.symbol_) {
+            return items_.begin() + static_cast<ptrdiff_t>(slot);
+        }
+        const iterator it = find(key.View());
+        if (it != end()) {
+            key.slot_.store(static_cast<uint32_t>(it - begin()), std::memory_order_relaxed);
+        }
+        return it;
+    }
+    const_iterator find(const Key& key) const {
+        return const_cast<SortedVectorMap&>(*this).find(key);
+    }
+    size_t count(std::string_view key) const { return find(key) != end() ? 1 : 0; }
+    bool contains(std::string_view key) const { return find(key) != end(); }
+
+    // Выбрасывают std::out_of_range, если ключа нет
+    Mapped& at(std::string_view key) {
+        const iterator it = find(key);
+        if (it == end()) {
+            throw std::out_of_range("SortedVectorMap::at");
+        }
+        return it->second;
+    }
+    const Mapped& at(std::string_view key) const {
+        return const_cast<SortedVectorMap&>(*this).at(key);
+    }
+    Mapped& at(const Key& key) {
+        const iterator it = find(key);
+        if (it == end()) {
+            throw std::out_of_range("SortedVectorMap::at");
+        }
+        return it->second;
+    }
+    const Mapped& at(const Key& key) const {
+        return const_cast<SortedVectorMap&>(*this).at(key);
+    }
+
+    Mapped& operator[](std::string_view key) {
+        return try_emplace(key).first->second;
+    }
+
+    // Вставляет значение, если ключа ещё нет. KeyText — Symbol или любая
+    // строка; Symbol создаётся, только если ключ действительно добавляется.
+    template <typename KeyText, typename... Args>
+    std::pair<iterator, bool> try_emplace(KeyText&& key, Args&&... args) {
+        const std::string_view text(key);
+        const iterator it = LowerBound(text);
+        if (it != end() && it->first == text) {
+            return {it, false};
+        }
+        return {items_.emplace(it, std::piecewise_construct, std::forward_as_tuple(std::forward<KeyText>(key)),
+                               std::forward_as_tuple(std::forward<Args>(args)...)),
+                true};
+    }
+
+    template <typename KeyText, typename... Args>
+    std::pair<iterator, bool> emplace(KeyText&& key, Args&&... args) {
+        return try_emplace(std::forward<KeyText>(key), std::forward<Args>(args)...);
+    }
+
+    // Подсказка не нужна: вставка в конец распознаётся и так
+    template <typename KeyText, typename... Args>
+    iterator emplace_hint(const_iterator, KeyText&& key, Args&&... args) {
+        return try_emplace(std::forward<KeyText>(key), std::forward<Args>(args)...).first;
+    }
+
+    std::pair<iterator, bool> insert(value_type item) {
+        const iterator it = LowerBound(item.first.View());
+        if (it != end() && it->first == item.first) {
+            return {it, false};
+        }
+        return {items_.insert(it, std::move(item)), true};
+    }
+
+    // Вставляет значение либо заменяет существующее
+    template <typename KeyText, typename Value>
+    std::pair<iterator, bool> insert_or_assign(KeyText&& key, Value&& value) {
+        const std::string_view text(key);
+        const iterator it = LowerBound(text);
+        if (it != end() && it->first == text) {
+            it->second = std::forward<Value>(value);
+            return {it, false};
+        }
+        return {items_.emplace(it, std::forward<KeyText>(key), std::forward<Value>(value)), true};
+    }
+
+    iterator erase(const_iterator pos) { return items_.erase(pos); }
+    size_t erase(std::string_view key) {
+        const iterator it = find(key);
+        if (it == end()) {
+            return 0;
+        }
+        items_.erase(it);
+        return 1;
+    }
+
+    bool operator==(const SortedVectorMap& other) const { return items_ == other.items_; }
+    bool operator!=(const SortedVectorMap& other) const { return !(*this == other); }
+
+private:
+    static constexpr size_t kLinearSearchLimit = 16;
+
+    iterator LowerBound(std::string_view key) {
+        // Ключи чаще всего приходят по возрастанию: проверяем конец первым
+        if (items_.empty() || std::string_view(items_.back().first) < key) {
+            return items_.end();
+        }
+        return std::lower_bound(items_.begin(), items_.end(), key, [](const value_type& item, std::string_view k) {
+            return std::string_view(item.first) < k;
+        });
+    }
+
+    std::pmr::vector<value_type> items_;
+};
+
+}  // namespace json::detail
@@ -0,0 +1,121 @@
+#include "json_file.h"
+#include "json_parser.h"
+
+#include <algorithm>
+#include <memory>
+#include <system_error>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+namespace json {
+
+namespace {
+
+[[noreturn]] void ThrowSystemError(const char* what) {
+#ifdef _WIN32
+    throw system_error(static_cast<int>(GetLastError()), system_category(), what);
+#else
+    throw system_error(errno, system_category(), what);
+#endif
+}
+
+}  // namespace
+
+#ifdef _WIN32
+
+MappedFile::MappedFile(const filesystem::path& path, Access access) {
+    const DWORD flags = access == Access::Sequential ? FILE_FLAG_SEQUENTIAL_SCAN : FILE_FLAG_RANDOM_ACCESS;
+    const HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, flags, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        ThrowSystemError("Cannot open file");
+    }
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size)) {
+        CloseHandle(file);
+        ThrowSystemError("Cannot get file size");
+    }
+    size_ = static_cast<size_t>(size.QuadPart);
+    // Пустой файл отобразить нельзя, да и незачем
+    if (size_ > 0) {
+        mapping_ = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mapping_ == nullptr) {
+            CloseHandle(file);
+            ThrowSystemError("Cannot map file");
+        }
+        data_ = static_cast<const char*>(MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0));
+        if (data_ == nullptr) {
+            CloseHandle(mapping_);
+            CloseHandle(file);
+            ThrowSystemError("Cannot map file");
+        }
+    }
+    // Отображение удерживает файл само
+    CloseHandle(file);
+}
+
+MappedFile::~MappedFile() {
+    if (data_ != nullptr) {
+        UnmapViewOfFile(data_);
+        CloseHandle(mapping_);
+    }
+}
+
+#else
+
+MappedFile::MappedFile(const filesystem::path& path, Access access) {
+    const int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        ThrowSystemError("Cannot open file");
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        const int error = errno;
+        close(fd);
+        errno = error;
+        ThrowSystemError("Cannot get file size");
+    }
+    size_ = static_cast<size_t>(info.st_size);
+    // Пустой файл отобразить нельзя, да и незачем
+    if (size_ > 0) {
+        void* data = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED) {
+            const int error = errno;
+            close(fd);
+            errno = error;
+            ThrowSystemError("Cannot map file");
+        }
+        madvise(data, size_, access == Access::Sequential ? MADV_SEQUENTIAL : MADV_RANDOM);
+        data_ = static_cast<const char*>(data);
+    }
+    // Отображение удерживает файл само
+    close(fd);
+}
+
+MappedFile::~MappedFile() {
+    if (data_ != nullptr) {
+        munmap(const_cast<char*>(data_), size_);
+    }
+}
+
+#endif
+
+Document LoadFile(const filesystem::path& path, const LoadOptions& options) {
+    auto file = make_shared<const MappedFile>(path);
+    const string_view text = file->GetText();
+    return detail::LoadOwnedBuffer(text, move(file), options, max<size_t>(text.size(), 4096));
+}
+
+}  // namespace json
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "json.h"
+
+#include <cstddef>
+#include <filesystem>
+#include <string_view>
+
+namespace json {
+
+// Файл, отображённый в память только для чтения. Содержимое читается
+// прямо из страничного кэша, без промежуточного буфера потока.
+class MappedFile {
+public:
+    // Подсказка системе, как будут читаться страницы
+    enum class Access {
+        // От начала к концу: страницы читаются с опережением
+        Sequential,
+        // Вразброс: опережающее чтение только мешает
+        Random,
+    };
+
+    // Выбрасывает std::system_error, если файл не удаётся открыть или отобразить
+    explicit MappedFile(const std::filesystem::path& path, Access access = Access::Sequential);
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    std::string_view GetText() const { return {data_, size_}; }
+    size_t GetSize() const { return size_; }
+
+private:
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+#ifdef _WIN32
+    void* mapping_ = nullptr;
+#endif
+};
+
+// Загружает документ из файла, отображённого в память. По умолчанию строки
+// копируются, и отображение закрывается сразу после разбора. С borrow_strings
+// строки без экранирования ссылаются прямо на отображение, как у LoadBuffer:
+// его удерживают документ и его копии, но не узлы, скопированные из документа.
+Document LoadFile(const std::filesystem::path& path, const LoadOptions& options = {});
+
+}  // namespace json
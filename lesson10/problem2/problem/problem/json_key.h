@@ -0,0 +1,215 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+
+namespace json {
+
+namespace detail {
+template <typename Mapped>
+class SortedVectorMap;
+}  // namespace detail
+
+// Неизменяемая строка ключа словаря. Ключ до 15 символов хранится прямо
+// в объекте, длинный — в блоке с подсчётом ссылок, который разделяют все
+// копии. При загрузке одинаковые длинные ключи получают один общий блок.
+class Symbol {
+public:
+    static constexpr size_t kInlineCapacity = 15;
+
+    Symbol() noexcept = default;
+    Symbol(std::string_view text) {
+        if (text.size() <= kInlineCapacity) {
+            // У пустого string_view data() может быть nullptr
+            if (!text.empty()) {
+                std::memcpy(storage_, text.data(), text.size());
+            }
+            storage_[kTagIndex] = static_cast<char>(text.size());
+            return;
+        }
+        void* memory = ::operator new(sizeof(Rep) + text.size());
+        Rep* rep = new (memory) Rep{{1}, text.size()};
+        std::memcpy(reinterpret_cast<char*>(rep + 1), text.data(), text.size());
+        SetRep(rep);
+    }
+    Symbol(const std::string& text) : Symbol(std::string_view(text)) {}
+    Symbol(const char* text) : Symbol(std::string_view(text)) {}
+
+    Symbol(const Symbol& other) noexcept {
+        std::memcpy(storage_, other.storage_, sizeof(storage_));
+        if (IsShared()) {
+            GetRep()->refs.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    Symbol(Symbol&& other) noexcept {
+        std::memcpy(storage_, other.storage_, sizeof(storage_));
+        std::memset(other.storage_, 0, sizeof(other.storage_));
+    }
+    Symbol& operator=(const Symbol& other) noexcept {
+        if (this != &other) {
+            Symbol copy(other);
+            Swap(copy);
+        }
+        return *this;
+    }
+    Symbol& operator=(Symbol&& other) noexcept {
+        if (this != &other) {
+            Symbol moved(std::move(other));
+            Swap(moved);
+        }
+        return *this;
+    }
+    ~Symbol() {
+        if (IsShared()) {
+            Rep* rep = GetRep();
+            if (rep->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                rep->~Rep();
+                ::operator delete(rep);
+            }
+        }
+    }
+
+    std::string_view View() const noexcept {
+        if (IsShared()) {
+            const Rep* rep = GetRep();
+            return {reinterpret_cast<const char*>(rep + 1), rep->size};
+        }
+        return {storage_, static_cast<size_t>(storage_[kTagIndex])};
+    }
+    operator std::string_view() const noexcept { return View(); }
+
+    size_t size() const noexcept { return View().size(); }
+    bool empty() const noexcept { return View().empty(); }
+
+    // Короткие ключи сравниваются целиком как 16 байт, общие блоки — по адресу
+    friend bool operator==(const Symbol& lhs, const Symbol& rhs) noexcept {
+        if (std::memcmp(lhs.storage_, rhs.storage_, sizeof(lhs.storage_)) == 0) {
+            return true;
+        }
+        return lhs.IsShared() && rhs.IsShared() && lhs.View() == rhs.View();
+    }
+    friend bool operator!=(const Symbol& lhs, const Symbol& rhs) noexcept { return !(lhs == rhs); }
+
+    template <typename Text, typename = std::enable_if_t<std::is_convertible_v<const Text&, std::string_view>
+                                                         && !std::is_same_v<Text, Symbol>>>
+    friend bool operator==(const Symbol& lhs, const Text& rhs) {
+        return lhs.View() == std::string_view(rhs);
+    }
+    template <typename Text, typename = std::enable_if_t<std::is_convertible_v<const Text&, std::string_view>
+                                                         && !std::is_same_v<Text, Symbol>>>
+    friend bool operator!=(const Symbol& lhs, const Text& rhs) {
+        return !(lhs == rhs);
+    }
+    template <typename Text, typename = std::enable_if_t<std::is_convertible_v<const Text&, std::string_view>
+                                                         && !std::is_same_v<Text, Symbol>>>
+    friend bool operator==(const Text& lhs, const Symbol& rhs) {
+        return rhs == lhs;
+    }
+    template <typename Text, typename = std::enable_if_t<std::is_convertible_v<const Text&, std::string_view>
+                                                         && !std::is_same_v<Text, Symbol>>>
+    friend bool operator!=(const Text& lhs, const Symbol& rhs) {
+        return !(rhs == lhs);
+    }
+
+private:
+    // За заголовком блока следуют символы ключа
+    struct Rep {
+        std::atomic<uint32_t> refs;
+        size_t size;
+    };
+
+    static constexpr size_t kTagIndex = kInlineCapacity;
+    // Длина короткого ключа не превышает 15, поэтому этот тег свободен
+    static constexpr char kSharedTag = '\x7f';
+
+    bool IsShared() const noexcept { return storage_[kTagIndex] == kSharedTag; }
+    Rep* GetRep() const noexcept {
+        Rep* rep;
+        std::memcpy(&rep, storage_, sizeof(rep));
+        return rep;
+    }
+    void SetRep(Rep* rep) noexcept {
+        std::memcpy(storage_, &rep, sizeof(rep));
+        storage_[kTagIndex] = kSharedTag;
+    }
+    void Swap(Symbol& other) noexcept {
+        char tmp[sizeof(storage_)];
+        std::memcpy(tmp, storage_, sizeof(storage_));
+        std::memcpy(storage_, other.storage_, sizeof(storage_));
+        std::memcpy(other.storage_, tmp, sizeof(storage_));
+    }
+
+    // Неиспользуемые байты всегда нулевые: на этом основано сравнение
+    alignas(8) char storage_[kInlineCapacity + 1] = {};
+};
+
+// Ключ, подготовленный для многократного поиска в словарях с одинаковым
+// набором полей, например в записях одного массива. Запоминает позицию,
+// на которой был найден в прошлый раз: если в следующем словаре ключ
+// стоит там же, поиск сводится к одному сравнению.
+//
+//     const json::Key price("price"sv);
+//     for (const Node& record : records) {
+//         total += record.AsMap().at(price).AsDouble();
+//     }
+class Key {
+public:
+    explicit Key(std::string_view text) : symbol_(text) {}
+    Key(const Key& other) : symbol_(other.symbol_), slot_(other.slot_.load(std::memory_order_relaxed)) {}
+    Key& operator=(const Key& other) {
+        symbol_ = other.symbol_;
+        slot_.store(other.slot_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        return *this;
+    }
+
+    const Symbol& GetSymbol() const { return symbol_; }
+    std::string_view View() const { return symbol_.View(); }
+
+private:
+    template <typename Mapped>
+    friend class detail::SortedVectorMap;
+
+    Symbol symbol_;
+    // Подсказка, а не часть значения, поэтому меняется и у const-ключа.
+    // Атомарна, чтобы одним ключом можно было пользоваться из разных потоков.
+    mutable std::atomic<uint32_t> slot_{0};
+};
+
+namespace detail {
+
+// Таблица ключей одной загрузки: одинаковые длинные ключи получают общий
+// блок памяти. Короткие ключи хранятся в самом Symbol и в таблицу не попадают.
+class KeyTable {
+public:
+    Symbol Intern(std::string_view text) {
+        if (text.size() <= Symbol::kInlineCapacity) {
+            return Symbol(text);
+        }
+        if (const auto it = symbols_.find(text); it != symbols_.end()) {
+            return it->second;
+        }
+        // Документ, где ключи не повторяются, не должен раздувать таблицу
+        if (symbols_.size() >= kMaxSize) {
+            symbols_.clear();
+        }
+        Symbol symbol(text);
+        symbols_.emplace(symbol.View(), symbol);
+        return symbol;
+    }
+
+private:
+    static constexpr size_t kMaxSize = 4096;
+
+    // Ключ таблицы ссылается на символы блока, который хранит значение
+    std::unordered_map<std::string_view, Symbol> symbols_;
+};
+
+}  // namespace detail
+
+}  // namespace json
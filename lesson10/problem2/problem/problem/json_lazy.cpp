@@ -0,0 +1,320 @@
+#include "json_lazy.h"
+#include "json_parser.h"
+#include "json_scan.h"
+
+#include <stdexcept>
+
+using namespace std;
+
+namespace json {
+
+bool LazyNode::IsNull() const {
+    return !IsContainer() && Scalar().IsNull();
+}
+
+bool LazyNode::IsBool() const {
+    return !IsContainer() && Scalar().IsBool();
+}
+
+bool LazyNode::IsInt() const {
+    return !IsContainer() && Scalar().IsInt();
+}
+
+bool LazyNode::IsInt64() const {
+    return !IsContainer() && Scalar().IsInt64();
+}
+
+bool LazyNode::IsUint64() const {
+    return !IsContainer() && Scalar().IsUint64();
+}
+
+bool LazyNode::IsDouble() const {
+    return !IsContainer() && Scalar().IsDouble();
+}
+
+bool LazyNode::IsPureDouble() const {
+    return !IsContainer() && Scalar().IsPureDouble();
+}
+
+bool LazyNode::IsString() const {
+    return *begin_ == '"';
+}
+
+bool LazyNode::AsBool() const {
+    if (IsContainer()) throw logic_error("Not a bool");
+    return Scalar().AsBool();
+}
+
+int LazyNode::AsInt() const {
+    if (IsContainer()) throw logic_error("Not an int");
+    return Scalar().AsInt();
+}
+
+int64_t LazyNode::AsInt64() const {
+    if (IsContainer()) throw logic_error("Not an int64");
+    return Scalar().AsInt64();
+}
+
+uint64_t LazyNode::AsUint64() const {
+    if (IsContainer()) throw logic_error("Not an uint64");
+    return Scalar().AsUint64();
+}
+
+double LazyNode::AsDouble() const {
+    if (IsContainer()) throw logic_error("Not a double");
+    return Scalar().AsDouble();
+}
+
+string_view LazyNode::AsString() const {
+    if (!IsString()) throw logic_error("Not a string");
+    return Scalar().AsString();
+}
+
+LazyArray LazyNode::AsArray() const {
+    if (!IsArray()) throw logic_error("Not an array");
+    return LazyArray(doc_, &doc_->GetContainer(begin_));
+}
+
+LazyDict LazyNode::AsMap() const {
+    if (!IsMap()) throw logic_error("Not a map");
+    return LazyDict(doc_, &doc_->GetContainer(begin_));
+}
+
+Node LazyNode::ToNode() const {
+    const string_view input = doc_->input_;
+    detail::DomBuilder builder;
+    detail::Parser parser(input.substr(static_cast<size_t>(begin_ - input.data())), builder);
+    parser.ParseValue();
+    return builder.ExtractRoot();
+}
+
+const Node& LazyNode::Scalar() const {
+    static const Node null_node;
+    if (IsContainer()) {
+        return null_node;
+    }
+    auto [it, inserted] = doc_->scalars_.try_emplace(begin_);
+    if (inserted) {
+        try {
+            // Строки без экранирования ссылаются на входной текст
+            const string_view input = doc_->input_;
+            detail::DomBuilder builder;
+            builder.BorrowStringsFrom(input);
+            detail::Parser parser(input.substr(static_cast<size_t>(begin_ - input.data())), builder);
+            parser.ParseValue();
+            it->second = builder.ExtractRoot();
+        } catch (...) {
+            doc_->scalars_.erase(it);
+            throw;
+        }
+    }
+    return it->second;
+}
+
+size_t LazyArray::Iterator::Position() const {
+    if (index_ == numeric_limits<size_t>::max() || !doc_->HasItem(*container_, index_)) {
+        return numeric_limits<size_t>::max();
+    }
+    return index_;
+}
+
+size_t LazyArray::size() const {
+    doc_->ScanToEnd(*container_);
+    return container_->values.size();
+}
+
+bool LazyArray::empty() const {
+    return !doc_->HasItem(*container_, 0);
+}
+
+LazyNode LazyArray::at(size_t index) const {
+    if (!doc_->HasItem(*container_, index)) {
+        throw out_of_range("Array index out of range");
+    }
+    return LazyNode(doc_, container_->values[index]);
+}
+
+size_t LazyDict::Iterator::Position() const {
+    if (index_ == numeric_limits<size_t>::max() || !doc_->HasItem(*container_, index_)) {
+        return numeric_limits<size_t>::max();
+    }
+    return index_;
+}
+
+size_t LazyDict::size() const {
+    doc_->ScanToEnd(*container_);
+    return container_->values.size();
+}
+
+bool LazyDict::empty() const {
+    return !doc_->HasItem(*container_, 0);
+}
+
+LazyDict::Iterator LazyDict::find(string_view key) const {
+    // Сначала среди уже найденных ключей, затем дочитывая словарь
+    for (size_t i = 0; doc_->HasItem(*container_, i); ++i) {
+        if (container_->keys[i] == key) {
+            return Iterator(doc_, container_, i);
+        }
+    }
+    return end();
+}
+
+LazyNode LazyDict::at(string_view key) const {
+    const Iterator it = find(key);
+    if (it == end()) {
+        throw out_of_range("Key not found: "s + string(key));
+    }
+    return (*it).second;
+}
+
+LazyDocument::LazyDocument(string_view input)
+    : input_(input) {
+    root_ = SkipWhitespace(input_.data());
+    if (root_ == End()) {
+        throw ParsingError("Unexpected end of input");
+    }
+}
+
+detail::LazyContainer& LazyDocument::GetContainer(const char* begin) const {
+    auto [it, inserted] = containers_.try_emplace(begin);
+    if (inserted) {
+        it->second.is_dict = *begin == '{';
+        it->second.begin = begin;
+    }
+    return it->second;
+}
+
+bool LazyDocument::HasItem(detail::LazyContainer& container, size_t index) const {
+    while (container.values.size() <= index) {
+        if (!ScanNext(container)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void LazyDocument::ScanToEnd(detail::LazyContainer& container) const {
+    while (ScanNext(container)) {
+    }
+}
+
+bool LazyDocument::ScanNext(detail::LazyContainer& container) const {
+    if (container.end != nullptr) {
+        return false;
+    }
+    const char close = container.is_dict ? '}' : ']';
+    const char* pos = container.values.empty() ? container.begin + 1 : SkipValue(container.values.back());
+    pos = SkipWhitespace(pos);
+    if (pos == End()) {
+        throw ParsingError(container.is_dict ? "Expected ',' or '}' in dictionary" : "Expected ',' or ']' in array");
+    }
+    if (*pos == close) {
+        container.end = pos + 1;
+        return false;
+    }
+    if (!container.values.empty()) {
+        if (*pos != ',') {
+            throw ParsingError(container.is_dict ? "Expected ',' or '}' in dictionary"
+                                                 : "Expected ',' or ']' in array");
+        }
+        pos = SkipWhitespace(pos + 1);
+    }
+
+    if (container.is_dict) {
+        if (pos == End() || *pos != '"') {
+            throw ParsingError("Dictionary key must be string");
+        }
+        const string_view key = ReadKey(pos);
+        pos = SkipWhitespace(pos);
+        if (pos == End() || *pos != ':') {
+            throw ParsingError("Expected ':' after dictionary key");
+        }
+        pos = SkipWhitespace(pos + 1);
+        container.keys.push_back(key);
+    }
+    if (pos == End()) {
+        throw ParsingError("Unexpected end of input");
+    }
+    container.values.push_back(pos);
+    return true;
+}
+
+string_view LazyDocument::ReadKey(const char*& pos) const {
+    const char* const begin = pos + 1;
+    const char* const end = SkipString(begin);
+    pos = end;
+    const string_view raw(begin, static_cast<size_t>(end - 1 - begin));
+    if (raw.find('\\') == string_view::npos) {
+        return raw;
+    }
+    // Экранирование разбирает обычный парсер
+    detail::DomBuilder builder;
+    detail::Parser parser(string_view(begin - 1, static_cast<size_t>(end - begin + 1)), builder);
+    parser.ParseValue();
+    return keys_.emplace_back(builder.ExtractRoot().AsString());
+}
+
+// Возвращает позицию сразу за значением, начинающимся в pos. Содержимое
+// строк и контейнеров не проверяется: это сделает разбор при обращении к ним.
+const char* LazyDocument::SkipValue(const char* pos) const {
+    const char* const end = End();
+    const char c = *pos;
+    if (c == '"') {
+        return SkipString(pos + 1);
+    }
+    if (c == '[' || c == '{') {
+        // Конец уже просмотренного контейнера известен
+        if (const auto it = containers_.find(pos); it != containers_.end() && it->second.end != nullptr) {
+            return it->second.end;
+        }
+        size_t depth = 0;
+        while (true) {
+            pos = detail::FindStructural(pos, end);
+            if (pos == end) {
+                throw ParsingError("Unbalanced brackets");
+            }
+            switch (*pos) {
+            case '"':
+                pos = SkipString(pos + 1);
+                continue;
+            case '[':
+            case '{':
+                ++depth;
+                break;
+            default:
+                if (--depth == 0) {
+                    return pos + 1;
+                }
+            }
+            ++pos;
+        }
+    }
+    // Число или литерал тянется до разделителя
+    while (pos != end && *pos != ',' && *pos != ']' && *pos != '}' && *pos != ' ' && *pos != '\t' && *pos != '\n'
+           && *pos != '\r') {
+        ++pos;
+    }
+    return pos;
+}
+
+// Возвращает позицию за закрывающей кавычкой строки, тело которой начинается в pos
+const char* LazyDocument::SkipString(const char* pos) const {
+    const char* const end = End();
+    while (true) {
+        pos = detail::FindStringSpecial(pos, end);
+        if (pos == end) {
+            throw ParsingError("String parsing error");
+        }
+        if (*pos == '"') {
+            return pos + 1;
+        }
+        pos += *pos == '\\' && end - pos > 1 ? 2 : 1;
+    }
+}
+
+const char* LazyDocument::SkipWhitespace(const char* pos) const {
+    return detail::SkipWhitespace(pos, End());
+}
+
+}  // namespace json
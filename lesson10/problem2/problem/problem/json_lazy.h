@@ -0,0 +1,257 @@
+#pragma once
+
+#include "json.h"
+
+#include <cstdint>
+#include <deque>
+#include <iterator>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace json {
+
+class LazyDocument;
+class LazyArray;
+class LazyDict;
+
+// Значение ленивого документа — позиция его начала во входном тексте.
+// Действительно, пока жив документ.
+class LazyNode {
+public:
+    bool IsNull() const;
+    bool IsBool() const;
+    bool IsInt() const;
+    bool IsInt64() const;
+    bool IsUint64() const;
+    bool IsDouble() const;
+    bool IsPureDouble() const;
+    bool IsString() const;
+    bool IsArray() const { return *begin_ == '['; }
+    bool IsMap() const { return *begin_ == '{'; }
+
+    bool AsBool() const;
+    int AsInt() const;
+    int64_t AsInt64() const;
+    uint64_t AsUint64() const;
+    double AsDouble() const;
+    std::string_view AsString() const;
+    LazyArray AsArray() const;
+    LazyDict AsMap() const;
+
+    // Полностью разбирает поддерево в обычный Node
+    Node ToNode() const;
+
+private:
+    friend class LazyDocument;
+    friend class LazyArray;
+    friend class LazyDict;
+
+    LazyNode(const LazyDocument* doc, const char* begin)
+        : doc_(doc)
+        , begin_(begin) {
+    }
+
+    bool IsContainer() const { return IsArray() || IsMap(); }
+    // Разобранное скалярное значение; для контейнера — null
+    const Node& Scalar() const;
+
+    const LazyDocument* doc_;
+    const char* begin_;
+};
+
+namespace detail {
+
+// Уже найденные элементы контейнера. Последнее значение перешагивается
+// только тогда, когда понадобится следующий элемент.
+struct LazyContainer {
+    std::vector<std::string_view> keys;
+    std::vector<const char*> values;
+    // Открывающая скобка и, когда контейнер просмотрен целиком, позиция за закрывающей
+    const char* begin = nullptr;
+    const char* end = nullptr;
+    bool is_dict = false;
+};
+
+}  // namespace detail
+
+// Массив ленивого документа. Элементы находятся по мере обращения к ним:
+// at(i) просматривает текст только до i-го элемента.
+class LazyArray {
+public:
+    class Iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = LazyNode;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+        using reference = LazyNode;
+
+        Iterator() = default;
+
+        LazyNode operator*() const { return LazyNode(doc_, container_->values[index_]); }
+        Iterator& operator++() {
+            ++index_;
+            return *this;
+        }
+        Iterator operator++(int) {
+            Iterator prev = *this;
+            ++index_;
+            return prev;
+        }
+        // Сравнение с end() дочитывает массив не дальше следующего элемента
+        bool operator==(const Iterator& other) const { return Position() == other.Position(); }
+        bool operator!=(const Iterator& other) const { return !(*this == other); }
+
+    private:
+        friend class LazyArray;
+        Iterator(const LazyDocument* doc, detail::LazyContainer* container, size_t index)
+            : doc_(doc)
+            , container_(container)
+            , index_(index) {
+        }
+
+        size_t Position() const;
+
+        const LazyDocument* doc_ = nullptr;
+        detail::LazyContainer* container_ = nullptr;
+        size_t index_ = std::numeric_limits<size_t>::max();
+    };
+
+    // Дочитывает массив до конца
+    size_t size() const;
+    bool empty() const;
+    LazyNode operator[](size_t index) const { return at(index); }
+    // Выбрасывает std::out_of_range, если элемента нет
+    LazyNode at(size_t index) const;
+
+    Iterator begin() const { return Iterator(doc_, container_, 0); }
+    Iterator end() const { return Iterator(doc_, container_, std::numeric_limits<size_t>::max()); }
+
+private:
+    friend class LazyNode;
+    LazyArray(const LazyDocument* doc, detail::LazyContainer* container)
+        : doc_(doc)
+        , container_(container) {
+    }
+
+    const LazyDocument* doc_;
+    detail::LazyContainer* container_;
+};
+
+// Словарь ленивого документа. Обход идёт в порядке текста, а не по ключу,
+// как у Dict. Поиск останавливается на первом совпадении, поэтому
+// из повторяющихся ключей виден первый (Load оставляет последний).
+class LazyDict {
+public:
+    class Iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = std::pair<std::string_view, LazyNode>;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+        using reference = value_type;
+
+        Iterator() = default;
+
+        value_type operator*() const {
+            return {container_->keys[index_], LazyNode(doc_, container_->values[index_])};
+        }
+        Iterator& operator++() {
+            ++index_;
+            return *this;
+        }
+        Iterator operator++(int) {
+            Iterator prev = *this;
+            ++index_;
+            return prev;
+        }
+        bool operator==(const Iterator& other) const { return Position() == other.Position(); }
+        bool operator!=(const Iterator& other) const { return !(*this == other); }
+
+    private:
+        friend class LazyDict;
+        Iterator(const LazyDocument* doc, detail::LazyContainer* container, size_t index)
+            : doc_(doc)
+            , container_(container)
+            , index_(index) {
+        }
+
+        size_t Position() const;
+
+        const LazyDocument* doc_ = nullptr;
+        detail::LazyContainer* container_ = nullptr;
+        size_t index_ = std::numeric_limits<size_t>::max();
+    };
+
+    // Дочитывает словарь до конца
+    size_t size() const;
+    bool empty() const;
+    size_t count(std::string_view key) const { return find(key) != end() ? 1 : 0; }
+    Iterator find(std::string_view key) const;
+    // Выбрасывает std::out_of_range, если ключа нет
+    LazyNode at(std::string_view key) const;
+
+    Iterator begin() const { return Iterator(doc_, container_, 0); }
+    Iterator end() const { return Iterator(doc_, container_, std::numeric_limits<size_t>::max()); }
+
+private:
+    friend class LazyNode;
+    LazyDict(const LazyDocument* doc, detail::LazyContainer* container)
+        : doc_(doc)
+        , container_(container) {
+    }
+
+    const LazyDocument* doc_;
+    detail::LazyContainer* container_;
+};
+
+// Документ, разбираемый по требованию. Контейнер просматривается при
+// первом обращении и только до нужного элемента, а ненужные значения
+// перешагиваются по парным скобкам без разбора. Найденные элементы
+// и разобранные скаляры запоминаются, так что повторное обращение
+// к тому же пути текст не перечитывает.
+//
+// Ошибки в тексте, до которого не дошло обращение, не обнаруживаются.
+// Документ изменяет свои кэши при чтении, поэтому не потокобезопасен
+// даже для константного доступа.
+class LazyDocument {
+public:
+    // Текст не копируется: input должен жить, пока жив документ
+    explicit LazyDocument(std::string_view input);
+
+    LazyDocument(const LazyDocument&) = delete;
+    LazyDocument& operator=(const LazyDocument&) = delete;
+
+    LazyNode GetRoot() const { return LazyNode(this, root_); }
+
+private:
+    friend class LazyNode;
+    friend class LazyArray;
+    friend class LazyDict;
+
+    detail::LazyContainer& GetContainer(const char* begin) const;
+    // Находит следующий элемент контейнера. Возвращает false, если их больше нет
+    bool ScanNext(detail::LazyContainer& container) const;
+    // Есть ли в контейнере элемент index; при необходимости дочитывает до него
+    bool HasItem(detail::LazyContainer& container, size_t index) const;
+    void ScanToEnd(detail::LazyContainer& container) const;
+
+    std::string_view ReadKey(const char*& pos) const;
+    const char* SkipValue(const char* pos) const;
+    const char* SkipString(const char* pos) const;
+    const char* SkipWhitespace(const char* pos) const;
+    const char* End() const { return input_.data() + input_.size(); }
+
+    std::string_view input_;
+    const char* root_;
+    mutable std::unordered_map<const char*, detail::LazyContainer> containers_;
+    mutable std::unordered_map<const char*, Node> scalars_;
+    // Ключи с экранированием, приведённые к обычному виду
+    mutable std::deque<std::string> keys_;
+};
+
+}  // namespace json
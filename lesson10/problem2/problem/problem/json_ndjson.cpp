@@ -0,0 +1,283 @@
+#include "json_ndjson.h"
+#include "json_parser.h"
+
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+namespace json {
+
+namespace {
+
+// Непрерывный участок входа, состоящий из целых строк
+struct Batch {
+    size_t index = 0;
+    string text;
+};
+
+struct BatchResult {
+    vector<Document> docs;
+    // Ошибка разбора строки, следующей за последним документом пакета
+    exception_ptr error;
+};
+
+BatchResult ParseBatch(const string& text, LoadOptions options) {
+    BatchResult result;
+    // Текст пакета освобождается после разбора, заимствовать из него нельзя
+    options.borrow_strings = false;
+    // Строки пакета обычно повторяют одни и те же ключи
+    detail::KeyTable keys;
+    try {
+        const char* pos = text.data();
+        const char* const end = text.data() + text.size();
+        while (pos != end) {
+            const char* line_end = static_cast<const char*>(memchr(pos, '\n', static_cast<size_t>(end - pos)));
+            if (line_end == nullptr) {
+                line_end = end;
+            }
+            if (detail::SkipWhitespace(pos, line_end) != line_end) {
+                string_view line(pos, static_cast<size_t>(line_end - pos));
+                result.docs.push_back(detail::LoadDocument(line, options, max<size_t>(line.size(), 1024), true, &keys));
+            }
+            pos = line_end == end ? end : line_end + 1;
+        }
+    } catch (...) {
+        result.error = current_exception();
+    }
+    return result;
+}
+
+WriterOptions MakeCompactOptions() {
+    WriterOptions options;
+    options.compact = true;
+    return options;
+}
+
+}  // namespace
+
+struct NdjsonReader::Impl {
+    Impl(istream& input, const NdjsonOptions& options)
+        : input(input)
+        , options(options) {
+        unsigned threads = options.threads != 0 ? options.threads : thread::hardware_concurrency();
+        threads = max(threads, 1u);
+        if (this->options.max_batches_in_flight == 0) {
+            this->options.max_batches_in_flight = 2 * threads;
+        }
+        this->options.batch_bytes = max<size_t>(this->options.batch_bytes, 1);
+        thread_count = threads;
+    }
+
+    // Потоки запускаются после того, как Impl принадлежит unique_ptr:
+    // если запуск очередного потока бросит исключение, деструктор
+    // остановит и дождётся уже запущенных
+    void Start() {
+        producer = thread([this] {
+            ReadInput();
+        });
+        workers.reserve(thread_count);
+        for (unsigned i = 0; i < thread_count; ++i) {
+            workers.emplace_back([this] {
+                ParseBatches();
+            });
+        }
+    }
+
+    ~Impl() {
+        {
+            lock_guard lock(state_mutex);
+            stop = true;
+        }
+        work_ready.notify_all();
+        space_ready.notify_all();
+        if (producer.joinable()) {
+            producer.join();
+        }
+        for (thread& worker : workers) {
+            worker.join();
+        }
+    }
+
+    // Поток чтения: режет вход на пакеты по границам строк
+    void ReadInput() {
+        size_t index = 0;
+        try {
+            string carry;
+            bool eof = false;
+            while (!eof) {
+                {
+                    unique_lock lock(state_mutex);
+                    space_ready.wait(lock, [this] {
+                        return stop || in_flight < options.max_batches_in_flight;
+                    });
+                    if (stop) {
+                        break;
+                    }
+                }
+
+                string text = move(carry);
+                carry.clear();
+                // Дочитываем, пока в пакете не окажется хотя бы одна целая строка
+                size_t last_newline = string::npos;
+                while (!eof && (text.size() < options.batch_bytes || last_newline == string::npos)) {
+                    const size_t old_size = text.size();
+                    text.resize(old_size + options.batch_bytes);
+                    input.read(text.data() + old_size, static_cast<streamsize>(options.batch_bytes));
+                    text.resize(old_size + static_cast<size_t>(input.gcount()));
+                    eof = !input;
+                    if (const size_t pos = string_view(text).substr(old_size).rfind('\n'); pos != string::npos) {
+                        last_newline = old_size + pos;
+                    }
+                }
+                if (!eof) {
+                    carry.assign(text, last_newline + 1);
+                    text.resize(last_newline + 1);
+                }
+                if (text.empty()) {
+                    continue;
+                }
+
+                {
+                    lock_guard lock(state_mutex);
+                    work.push_back(Batch{index, move(text)});
+                    ++index;
+                    ++in_flight;
+                }
+                work_ready.notify_one();
+            }
+            lock_guard lock(state_mutex);
+            total_batches = index;
+        } catch (...) {
+            // Уже отправленные пакеты выдаются до ошибки
+            lock_guard lock(state_mutex);
+            input_error = current_exception();
+            total_batches = index;
+        }
+        {
+            lock_guard lock(state_mutex);
+            input_done = true;
+        }
+        work_ready.notify_all();
+        result_ready.notify_all();
+    }
+
+    // Потоки разбора: берут пакеты из очереди в любом порядке
+    void ParseBatches() {
+        while (true) {
+            Batch batch;
+            {
+                unique_lock lock(state_mutex);
+                work_ready.wait(lock, [this] {
+                    return stop || !work.empty() || input_done;
+                });
+                if (stop || work.empty()) {
+                    return;
+                }
+                batch = move(work.front());
+                work.pop_front();
+            }
+            BatchResult result = ParseBatch(batch.text, options.load);
+            {
+                lock_guard lock(state_mutex);
+                results.emplace(batch.index, move(result));
+            }
+            result_ready.notify_all();
+        }
+    }
+
+    // Забирает следующий по порядку пакет; false, если пакетов больше нет
+    bool TakeNextBatch() {
+        unique_lock lock(state_mutex);
+        result_ready.wait(lock, [this] {
+            return results.count(next_batch) != 0 || (input_done && next_batch >= total_batches);
+        });
+        const auto it = results.find(next_batch);
+        if (it == results.end()) {
+            if (input_error) {
+                rethrow_exception(exchange(input_error, nullptr));
+            }
+            return false;
+        }
+        current = move(it->second);
+        results.erase(it);
+        current_pos = 0;
+        ++next_batch;
+        --in_flight;
+        lock.unlock();
+        space_ready.notify_one();
+        return true;
+    }
+
+    istream& input;
+    NdjsonOptions options;
+    unsigned thread_count = 1;
+
+    mutex state_mutex;
+    condition_variable work_ready;
+    condition_variable result_ready;
+    condition_variable space_ready;
+    deque<Batch> work;
+    // Разобранные пакеты, ещё не забранные потребителем, по номеру
+    map<size_t, BatchResult> results;
+    size_t in_flight = 0;
+    size_t total_batches = 0;
+    bool input_done = false;
+    bool stop = false;
+    exception_ptr input_error;
+
+    // Состояние потребителя; доступно только из Next()
+    size_t next_batch = 0;
+    BatchResult current;
+    size_t current_pos = 0;
+    bool failed = false;
+
+    thread producer;
+    vector<thread> workers;
+};
+
+NdjsonReader::NdjsonReader(istream& input, const NdjsonOptions& options)
+    : impl_(make_unique<Impl>(input, options)) {
+    impl_->Start();
+}
+
+NdjsonReader::~NdjsonReader() = default;
+
+optional<Document> NdjsonReader::Next() {
+    Impl& impl = *impl_;
+    while (!impl.failed) {
+        if (impl.current_pos < impl.current.docs.size()) {
+            return move(impl.current.docs[impl.current_pos++]);
+        }
+        if (impl.current.error) {
+            impl.failed = true;
+            rethrow_exception(exchange(impl.current.error, nullptr));
+        }
+        if (!impl.TakeNextBatch()) {
+            return nullopt;
+        }
+    }
+    return nullopt;
+}
+
+NdjsonWriter::NdjsonWriter(ostream& output)
+    : writer_(output, MakeCompactOptions()) {
+}
+
+void NdjsonWriter::Write(const Document& doc) {
+    writer_.Write(doc.GetRoot());
+    writer_.WriteRaw("\n"sv);
+}
+
+void NdjsonWriter::Flush() {
+    writer_.Flush();
+}
+
+}  // namespace json
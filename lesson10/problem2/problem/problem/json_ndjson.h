@@ -0,0 +1,61 @@
+#pragma once
+
+#include "json.h"
+#include "json_writer.h"
+
+#include <cstddef>
+#include <iosfwd>
+#include <memory>
+#include <optional>
+
+namespace json {
+
+struct NdjsonOptions {
+    // Число потоков разбора; 0 — по числу аппаратных потоков
+    unsigned threads = 0;
+    // Примерный объём одного пакета строк, отдаваемого потоку разбора
+    size_t batch_bytes = size_t{1} << 20;
+    // Сколько пакетов может одновременно ждать разбора или выдачи;
+    // 0 — по два на поток. Ограничивает расход памяти при медленном потребителе.
+    size_t max_batches_in_flight = 0;
+    LoadOptions load;
+};
+
+// Чтение JSON Lines: по одному документу в строке. Вход читается отдельным
+// потоком и делится по переводам строк на пакеты, пакеты разбираются
+// параллельно, а документы выдаются строго в порядке следования во входе.
+// Пустые строки пропускаются. Поток ввода должен жить, пока жив читатель.
+class NdjsonReader {
+public:
+    explicit NdjsonReader(std::istream& input, const NdjsonOptions& options = {});
+    ~NdjsonReader();
+
+    NdjsonReader(const NdjsonReader&) = delete;
+    NdjsonReader& operator=(const NdjsonReader&) = delete;
+
+    // Следующий документ либо nullopt в конце входа. Ошибка разбора строки
+    // выбрасывается после выдачи всех предшествующих ей документов
+    // и завершает чтение. Исключение из потока ввода выбрасывается после
+    // документов, прочитанных до него целыми пакетами.
+    std::optional<Document> Next();
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> impl_;
+};
+
+// Запись JSON Lines: каждый документ в компактном виде на отдельной строке.
+// Строки копятся в общем буфере и попадают в поток при его заполнении,
+// в Flush и в деструкторе.
+class NdjsonWriter {
+public:
+    explicit NdjsonWriter(std::ostream& output);
+
+    void Write(const Document& doc);
+    void Flush();
+
+private:
+    Writer writer_;
+};
+
+}  // namespace json
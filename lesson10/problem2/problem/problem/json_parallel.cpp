@@ -0,0 +1,302 @@
+#include "json_parallel.h"
+#include "json_parser.h"
+
+#include <exception>
+#include <thread>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+namespace json {
+
+namespace {
+
+// Позиции структурных символов вне строк. Для открывающих скобок
+// хранится номер парной закрывающей.
+class StructuralIndex {
+public:
+    // Индексирует входной текст до закрытия корневого контейнера
+    explicit StructuralIndex(string_view input) {
+        positions_.reserve(input.size() / 16);
+        vector<size_t> open;
+        const char* const begin = input.data();
+        const char* const end = begin + input.size();
+        for (const char* pos = begin; pos != end; ++pos) {
+            // Отступы занимают большую часть текста вне строк, их пропускаем блоками
+            pos = detail::SkipWhitespace(pos, end);
+            if (pos == end) {
+                break;
+            }
+            const char c = *pos;
+            if (c == '"') {
+                Add(pos - begin);
+                pos = SkipString(pos + 1, end);
+            } else if (c == '[' || c == '{') {
+                open.push_back(positions_.size());
+                Add(pos - begin);
+            } else if (c == ']' || c == '}') {
+                if (open.empty() || input[positions_[open.back()]] != (c == ']' ? '[' : '{')) {
+                    throw ParsingError("Unbalanced brackets");
+                }
+                matches_[open.back()] = positions_.size();
+                open.pop_back();
+                Add(pos - begin);
+                if (open.empty()) {
+                    return;
+                }
+            } else if (c == ':' || c == ',') {
+                Add(pos - begin);
+            }
+        }
+        throw ParsingError("Unbalanced brackets");
+    }
+
+    size_t Position(size_t i) const { return positions_[i]; }
+    size_t Match(size_t i) const { return matches_[i]; }
+
+private:
+    void Add(ptrdiff_t position) {
+        positions_.push_back(static_cast<size_t>(position));
+        matches_.push_back(0);
+    }
+
+    // Возвращает указатель на закрывающую кавычку строки
+    static const char* SkipString(const char* pos, const char* end) {
+        while (true) {
+            pos = detail::FindStringSpecial(pos, end);
+            if (pos == end) {
+                throw ParsingError("String parsing error");
+            }
+            if (*pos == '"') {
+                return pos;
+            }
+            // Экранированный символ и управляющие символы проверит второй этап
+            pos += *pos == '\\' && end - pos > 1 ? 2 : 1;
+        }
+    }
+
+    vector<size_t> positions_;
+    vector<size_t> matches_;
+};
+
+class ParallelParser {
+public:
+    ParallelParser(string_view input, const StructuralIndex& index, const ParallelLoadOptions& options)
+        : input_(input)
+        , index_(index)
+        , options_(options) {
+    }
+
+    // Корневой контейнер начинается с нулевой записи индекса
+    Node ParseRoot() {
+        return ParseContainer(0, index_.Position(index_.Match(0)) + 1);
+    }
+
+private:
+    // Участок текста [begin, end)
+    struct Span {
+        size_t begin;
+        size_t end;
+    };
+
+    char At(size_t i) const { return input_[index_.Position(i)]; }
+
+    // Номер записи-разделителя, следующей за значением, которое начинается
+    // не раньше записи i. Числа и литералы в индекс не попадают, поэтому
+    // за ними сразу идёт разделитель.
+    size_t SkipValue(size_t i) const {
+        const char c = At(i);
+        if (c == '[' || c == '{') {
+            return index_.Match(i) + 1;
+        } else if (c == '"') {
+            return i + 1;
+        }
+        return i;
+    }
+
+    bool IsBlank(size_t begin, size_t end) const {
+        return detail::SkipWhitespace(input_.data() + begin, input_.data() + end) == input_.data() + end;
+    }
+
+    // Однопоточный разбор значения, занимающего весь участок текста
+    Node ParseSequential(Span span, detail::DomBuilder& builder) const {
+        detail::Parser parser(input_.substr(span.begin, span.end - span.begin), builder);
+        parser.ParseValue();
+        if (parser.SkipWhitespace()) {
+            throw ParsingError("Unexpected data after JSON value");
+        }
+        return builder.ExtractRoot();
+    }
+
+    // Разбирает контейнер, открывающийся записью open; end — конец его участка текста
+    Node ParseContainer(size_t open, size_t end) {
+        const size_t begin = index_.Position(open);
+        if (end - begin < options_.min_parallel_bytes) {
+            return ParseSequential(Span{begin, end}, builder_);
+        }
+        return At(open) == '[' ? ParseArray(open) : ParseDict(open);
+    }
+
+    // Значение участка span, начинающееся не раньше записи first, — контейнер
+    bool IsContainer(size_t first, Span span) const {
+        return (At(first) == '[' || At(first) == '{') && IsBlank(span.begin, index_.Position(first));
+    }
+
+    // Значение внутри контейнера, начинающееся не раньше записи first:
+    // крупные контейнеры разбираются рекурсивно, остальное — однопоточно
+    Node ParseMember(size_t first, Span span) {
+        if (IsContainer(first, span)) {
+            // Разделитель ищется после закрывающей скобки, между ними
+            // могут оказаться лишние данные
+            if (!IsBlank(index_.Position(index_.Match(first)) + 1, span.end)) {
+                throw ParsingError("Unexpected data after JSON value");
+            }
+            return ParseContainer(first, span.end);
+        }
+        return ParseSequential(span, builder_);
+    }
+
+    Node ParseDict(size_t open) {
+        const size_t close = index_.Match(open);
+        if (open + 1 == close && IsBlank(index_.Position(open) + 1, index_.Position(close))) {
+            return Node(Dict{});
+        }
+
+        // Элементы копятся в порядке текста и сортируются один раз, как в DomBuilder
+        pmr::vector<Dict::value_type> members;
+
+        size_t i = open;
+        while (true) {
+            // Ключ, двоеточие, значение и разделитель
+            if (i + 2 > close || At(i + 1) != '"' || At(i + 2) != ':'
+                || !IsBlank(index_.Position(i) + 1, index_.Position(i + 1))) {
+                throw ParsingError("Dictionary key must be string");
+            }
+            const Node key = ParseSequential(Span{index_.Position(i + 1), index_.Position(i + 2)}, builder_);
+            const size_t separator = SkipValue(i + 3);
+            if (separator > close || (At(separator) != ',' && At(separator) != '}')) {
+                throw ParsingError("Expected ',' or '}' in dictionary");
+            }
+            const Span value{index_.Position(i + 2) + 1, index_.Position(separator)};
+            members.emplace_back(builder_.InternKey(key.AsString()), ParseMember(i + 3, value));
+            if (separator == close) {
+                break;
+            }
+            i = separator;
+        }
+        return Node(Dict::FromUnordered(move(members)));
+    }
+
+    Node ParseArray(size_t open) {
+        const size_t close = index_.Match(open);
+        // Элемент: первая запись индекса, не раньше которой он начинается, и его текст
+        struct Item {
+            size_t first;
+            Span span;
+        };
+        vector<Item> items;
+        if (!(open + 1 == close && IsBlank(index_.Position(open) + 1, index_.Position(close)))) {
+            size_t i = open;
+            while (true) {
+                const size_t separator = SkipValue(i + 1);
+                if (separator > close || (At(separator) != ',' && At(separator) != ']')) {
+                    throw ParsingError("Expected ',' or ']' in array");
+                }
+                items.push_back(Item{i + 1, Span{index_.Position(i) + 1, index_.Position(separator)}});
+                if (separator == close) {
+                    break;
+                }
+                i = separator;
+            }
+        }
+
+        // Крупные вложенные контейнеры разбираются рекурсивно после остальных
+        // элементов, сами деля свои элементы между потоками
+        vector<size_t> small;
+        vector<size_t> large;
+        size_t total_bytes = 0;
+        for (size_t k = 0; k < items.size(); ++k) {
+            const Span span = items[k].span;
+            if (span.end - span.begin >= options_.min_parallel_bytes && IsContainer(items[k].first, span)) {
+                large.push_back(k);
+            } else {
+                small.push_back(k);
+                total_bytes += span.end - span.begin + 1;
+            }
+        }
+
+        unsigned threads = options_.threads != 0 ? options_.threads : thread::hardware_concurrency();
+        threads = static_cast<unsigned>(min<size_t>(max(threads, 1u), max<size_t>(small.size(), 1)));
+
+        // Делим мелкие элементы на непрерывные части примерно равного объёма текста
+        vector<size_t> bounds{0};
+        size_t acc = 0;
+        for (size_t k = 0; k < small.size(); ++k) {
+            const Span span = items[small[k]].span;
+            acc += span.end - span.begin + 1;
+            if (bounds.size() < threads && acc * threads >= total_bytes * bounds.size()) {
+                bounds.push_back(k + 1);
+            }
+        }
+        bounds.push_back(small.size());
+
+        // Потоки пишут каждый в свои элементы результата
+        Array result(items.size());
+        const size_t parts = bounds.size() - 1;
+        vector<exception_ptr> errors(parts);
+        auto parse_part = [&](size_t part) {
+            try {
+                detail::DomBuilder builder;
+                for (size_t k = bounds[part]; k < bounds[part + 1]; ++k) {
+                    result[small[k]] = ParseSequential(items[small[k]].span, builder);
+                }
+            } catch (...) {
+                errors[part] = current_exception();
+            }
+        };
+
+        {
+            // jthread присоединяется в деструкторе, в том числе если запуск
+            // следующего потока бросит исключение
+            vector<jthread> workers;
+            workers.reserve(parts);
+            for (size_t part = 1; part < parts; ++part) {
+                workers.emplace_back(parse_part, part);
+            }
+            if (parts > 0) {
+                parse_part(0);
+            }
+        }
+        for (const exception_ptr& error : errors) {
+            if (error) {
+                rethrow_exception(error);
+            }
+        }
+
+        for (const size_t k : large) {
+            result[k] = ParseMember(items[k].first, items[k].span);
+        }
+        return Node(move(result));
+    }
+
+    string_view input_;
+    const StructuralIndex& index_;
+    ParallelLoadOptions options_;
+    // Строитель для однопоточных участков вне рабочих потоков
+    detail::DomBuilder builder_;
+};
+
+}  // namespace
+
+Document LoadParallel(string_view input, const ParallelLoadOptions& options) {
+    const char* const first = detail::SkipWhitespace(input.data(), input.data() + input.size());
+    if (first == input.data() + input.size() || (*first != '[' && *first != '{')) {
+        return Load(input);
+    }
+    const string_view root = input.substr(static_cast<size_t>(first - input.data()));
+    const StructuralIndex index(root);
+    return Document{ParallelParser(root, index, options).ParseRoot()};
+}
+
+}  // namespace json
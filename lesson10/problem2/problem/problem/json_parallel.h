@@ -0,0 +1,28 @@
+#pragma once
+
+#include "json.h"
+
+#include <cstddef>
+#include <string_view>
+
+namespace json {
+
+struct ParallelLoadOptions {
+    // Число потоков разбора; 0 — по числу аппаратных потоков
+    unsigned threads = 0;
+    // Контейнеры, занимающие меньше этого числа байт, разбираются одним потоком
+    size_t min_parallel_bytes = size_t{1} << 16;
+};
+
+// Двухэтапный разбор большого документа. Сначала строится структурный
+// индекс — позиции скобок, двоеточий, запятых и открывающих кавычек вне
+// строк. Затем элементы больших массивов по этому индексу делятся между
+// потоками и разбираются параллельно. Крупные вложенные контейнеры, и в
+// словарях, и в элементах массивов, обходятся так же рекурсивно, поэтому
+// большой массив внутри обёртки вроде [{"data": [...]}] тоже делится.
+// Результат собирается в один документ, равный тому, что вернул бы Load.
+// Контейнеры размещаются в обычной куче: монотонная арена не допускает
+// выделения из нескольких потоков.
+Document LoadParallel(std::string_view input, const ParallelLoadOptions& options = {});
+
+}  // namespace json
@@ -0,0 +1,594 @@
+#pragma once
+
+#include "json.h"
+#include "json_scan.h"
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <climits>
+#include <cstdint>
+#include <functional>
+#include <istream>
+#include <memory>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace json::detail {
+
+inline bool IsDigit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+// Сообщает обработчику о числе [start, end), уже проверенном по грамматике
+// JSON, без промежуточной строки и исключений. Целое получает самый узкий
+// подходящий тип, а не влезшее ни в один из них становится double.
+template <typename Handler>
+void EmitNumber(const char* start, const char* end, bool is_int, Handler& handler) {
+    using namespace std::literals;
+
+    if (is_int) {
+        if (*start == '-') {
+            int64_t value;
+            if (std::from_chars(start, end, value).ec == std::errc{}) {
+                if (value >= INT_MIN) {
+                    handler.Int(static_cast<int>(value));
+                } else {
+                    handler.Int64(value);
+                }
+                return;
+            }
+        } else {
+            uint64_t value;
+            if (std::from_chars(start, end, value).ec == std::errc{}) {
+                if (value <= static_cast<uint64_t>(INT_MAX)) {
+                    handler.Int(static_cast<int>(value));
+                } else if (value <= static_cast<uint64_t>(INT64_MAX)) {
+                    handler.Int64(static_cast<int64_t>(value));
+                } else {
+                    handler.Uint64(value);
+                }
+                return;
+            }
+        }
+    }
+    double value;
+    if (std::from_chars(start, end, value).ec != std::errc{}) {
+        throw ParsingError("Failed to convert "s + std::string(start, end) + " to number"s);
+    }
+    handler.Double(value);
+}
+
+// Рекурсивный спуск, сообщающий о каждом токене обработчику событий.
+// Handler должен иметь методы Null(), Bool(bool), Int(int), Int64(int64_t),
+// Uint64(uint64_t), Double(double), String(string_view), StartArray(), EndArray(), StartObject(), Key(string_view)
+// и EndObject(). Переданные обработчику string_view действительны только
+// на время вызова.
+//
+// Вход — либо непрерывный буфер, который должен жить, пока работает парсер,
+// либо поток, читаемый блоками: в памяти держится только текущий блок
+// и незавершённый токен.
+template <typename Handler>
+class Parser {
+public:
+    Parser(std::string_view input, Handler& handler)
+        : pos_(input.data())
+        , end_(input.data() + input.size())
+        , handler_(handler) {
+    }
+
+    Parser(std::istream& input, Handler& handler, size_t chunk_size = size_t{1} << 16)
+        : stream_(&input)
+        , chunk_size_(chunk_size)
+        , pos_(buffer_.data())
+        , end_(buffer_.data())
+        , handler_(handler) {
+    }
+
+    Parser(const Parser&) = delete;
+    Parser& operator=(const Parser&) = delete;
+
+    // Разбирает одно значение и сообщает о нём обработчику
+    void ParseValue() {
+        if (!SkipWhitespace()) {
+            throw ParsingError("Unexpected end of input");
+        }
+        const char c = *pos_;
+
+        if (c == '[') {
+            ParseArray();
+        } else if (c == '{') {
+            ParseDict();
+        } else if (c == '"') {
+            handler_.String(ParseString());
+        } else if (c == 'n') {
+            ParseLiteral("null");
+            handler_.Null();
+        } else if (c == 't') {
+            ParseLiteral("true");
+            handler_.Bool(true);
+        } else if (c == 'f') {
+            ParseLiteral("false");
+            handler_.Bool(false);
+        } else if (IsDigit(c) || c == '-') {
+            ParseNumber();
+        } else {
+            throw ParsingError("Unexpected character: " + std::string(1, c));
+        }
+    }
+
+    // Пропускает пробельные символы. Возвращает false, если вход исчерпан
+    bool SkipWhitespace() {
+        while (true) {
+            pos_ = detail::SkipWhitespace(pos_, end_);
+            if (pos_ != end_) {
+                return true;
+            }
+            if (!Refill()) {
+                return false;
+            }
+        }
+    }
+
+    // Извлекает следующий значимый символ; при исчерпании ввода — ошибка
+    char NextToken(const char* error) {
+        if (!SkipWhitespace()) {
+            throw ParsingError(error);
+        }
+        return *pos_++;
+    }
+
+    // Следующий значимый символ без извлечения либо '\0' в конце ввода
+    char PeekToken() {
+        return SkipWhitespace() ? *pos_ : '\0';
+    }
+
+private:
+    bool Refill() {
+        const char* keep = pos_;
+        return Refill(keep);
+    }
+
+    // Дочитывает очередной блок потока. Символы [keep, end_) переносятся
+    // в начало буфера, keep и pos_ сдвигаются вместе с ними.
+    bool Refill(const char*& keep) {
+        if (stream_ == nullptr) {
+            return false;
+        }
+        const size_t pos_offset = static_cast<size_t>(pos_ - keep);
+        buffer_.erase(0, static_cast<size_t>(keep - buffer_.data()));
+        const size_t kept = buffer_.size();
+        buffer_.resize(kept + chunk_size_);
+        stream_->read(buffer_.data() + kept, static_cast<std::streamsize>(chunk_size_));
+        buffer_.resize(kept + static_cast<size_t>(stream_->gcount()));
+
+        keep = buffer_.data();
+        pos_ = keep + pos_offset;
+        end_ = buffer_.data() + buffer_.size();
+        return buffer_.size() > kept;
+    }
+
+    void ParseNumber() {
+        using namespace std::literals;
+
+        const char* start = pos_;
+        // Число может оказаться на границе блоков, поэтому при дочитывании
+        // его начало переносится вместе с хвостом буфера
+        auto peek = [this, &start]() -> int {
+            if (pos_ == end_ && !Refill(start)) {
+                return -1;
+            }
+            return *pos_;
+        };
+        auto read_digits = [this, &peek] {
+            if (int ch = peek(); ch < 0 || !IsDigit(static_cast<char>(ch))) {
+                throw ParsingError("A digit is expected"s);
+            }
+            for (int ch = peek(); ch >= 0 && IsDigit(static_cast<char>(ch)); ch = peek()) {
+                ++pos_;
+            }
+        };
+
+        if (peek() == '-') {
+            ++pos_;
+        }
+
+        if (peek() == '0') {
+            ++pos_;
+        } else {
+            read_digits();
+        }
+
+        bool is_int = true;
+        if (peek() == '.') {
+            ++pos_;
+            read_digits();
+            is_int = false;
+        }
+
+        if (int ch = peek(); ch == 'e' || ch == 'E') {
+            ++pos_;
+            if (ch = peek(); ch == '+' || ch == '-') {
+                ++pos_;
+            }
+            read_digits();
+            is_int = false;
+        }
+
+        // Благодаря Refill(start) число целиком лежит в буфере, поэтому
+        // разбираем его на месте, без промежуточной строки
+        EmitNumber(start, pos_, is_int, handler_);
+    }
+
+    // Возвращает содержимое строки. Если строка не содержит экранирования
+    // и целиком лежит в буфере, она не копируется.
+    std::string_view ParseString() {
+        using namespace std::literals;
+
+        // Пропускаем открывающую кавычку
+        ++pos_;
+        const char* run = pos_;
+        bool use_scratch = false;
+        scratch_.clear();
+
+        while (true) {
+            pos_ = detail::FindStringSpecial(pos_, end_);
+            if (pos_ == end_) {
+                scratch_.append(run, pos_);
+                use_scratch = true;
+                if (!Refill()) {
+                    throw ParsingError("String parsing error");
+                }
+                run = pos_;
+                continue;
+            }
+            const char ch = *pos_;
+            if (ch == '"') {
+                std::string_view result(run, static_cast<size_t>(pos_ - run));
+                if (use_scratch) {
+                    scratch_.append(result);
+                    result = scratch_;
+                }
+                ++pos_;
+                return result;
+            } else if (ch == '\\') {
+                scratch_.append(run, pos_);
+                use_scratch = true;
+                ++pos_;
+                if (pos_ == end_ && !Refill()) {
+                    throw ParsingError("String parsing error");
+                }
+                const char escaped_char = *pos_;
+                switch (escaped_char) {
+                case 'n': scratch_.push_back('\n'); break;
+                case 't': scratch_.push_back('\t'); break;
+                case 'r': scratch_.push_back('\r'); break;
+                case '"': scratch_.push_back('"'); break;
+                case '\\': scratch_.push_back('\\'); break;
+                default: throw ParsingError("Unrecognized escape sequence \\"s + escaped_char);
+                }
+                run = ++pos_;
+            } else if (ch == '\n' || ch == '\r') {
+                throw ParsingError("Unexpected end of line"s);
+            } else {
+                // Прочие управляющие символы переносим в строку как есть
+                ++pos_;
+            }
+        }
+    }
+
+    void ParseLiteral(std::string_view word) {
+        const char* start = pos_;
+        while (static_cast<size_t>(end_ - pos_) < word.size() && Refill(start)) {
+        }
+        const std::string_view actual(pos_, std::min(word.size(), static_cast<size_t>(end_ - pos_)));
+        if (actual != word) {
+            throw ParsingError("Invalid literal: " + std::string(actual));
+        }
+        pos_ += word.size();
+        // Проверяем, что после ключевого слова идет разделитель
+        if (SkipWhitespace() && std::isalnum(static_cast<unsigned char>(*pos_))) {
+            throw ParsingError("Invalid value after " + std::string(word));
+        }
+    }
+
+    void ParseArray() {
+        ++pos_; // read '['
+        handler_.StartArray();
+
+        if (PeekToken() == ']') {
+            ++pos_;
+            handler_.EndArray();
+            return;
+        }
+
+        while (true) {
+            ParseValue();
+            const char c = NextToken("Expected ',' or ']' in array");
+            if (c == ']') {
+                break;
+            } else if (c != ',') {
+                throw ParsingError("Expected ',' or ']' in array");
+            }
+        }
+        handler_.EndArray();
+    }
+
+    void ParseDict() {
+        ++pos_; // read '{'
+        handler_.StartObject();
+
+        if (PeekToken() == '}') {
+            ++pos_;
+            handler_.EndObject();
+            return;
+        }
+
+        while (true) {
+            if (PeekToken() != '"') {
+                throw ParsingError("Dictionary key must be string");
+            }
+            handler_.Key(ParseString());
+
+            if (NextToken("Expected ':' after dictionary key") != ':') {
+                throw ParsingError("Expected ':' after dictionary key");
+            }
+
+            ParseValue();
+
+            const char c = NextToken("Expected ',' or '}' in dictionary");
+            if (c == '}') {
+                break;
+            } else if (c != ',') {
+                throw ParsingError("Expected ',' or '}' in dictionary");
+            }
+        }
+        handler_.EndObject();
+    }
+
+    // Потоковый режим: источник и буфер текущего блока
+    std::istream* stream_ = nullptr;
+    size_t chunk_size_ = 0;
+    std::string buffer_;
+
+    const char* pos_;
+    const char* end_;
+    // Строки с экранированием или на границе блоков собираются здесь
+    std::string scratch_;
+    Handler& handler_;
+};
+
+// Уже встреченные поддеревья для их разделения (hash-consing). Поддерево
+// сравнивается с кандидатами по хэшу, а вложенные в него поддеревья к этому
+// моменту уже общие, так что сравнение сводится к сравнению указателей.
+class SubtreeTable {
+public:
+    // Общий узел, равный node, если такой уже встречался
+    const Node* Find(const Node& node) const {
+        if (!IsCandidate(node)) {
+            return nullptr;
+        }
+        const auto [begin, end] = nodes_.equal_range(node.Hash());
+        for (auto it = begin; it != end; ++it) {
+            if (it->second == node) {
+                return &it->second;
+            }
+        }
+        return nullptr;
+    }
+
+    // Общий узел, равный node: найденный либо созданный из node
+    Node Intern(Node node) {
+        if (!IsCandidate(node)) {
+            return node;
+        }
+        if (const Node* found = Find(node)) {
+            return *found;
+        }
+        const size_t hash = node.Hash();
+        return nodes_.emplace(hash, Node::Share(std::move(node)))->second;
+    }
+
+private:
+    // Пустые контейнеры и скаляры не занимают памяти в куче сверх самого узла
+    static bool IsCandidate(const Node& node) {
+        return (node.IsArray() && !node.AsArray().empty()) || (node.IsMap() && !node.AsMap().empty());
+    }
+
+    std::unordered_multimap<size_t, Node> nodes_;
+};
+
+// Обработчик, строящий дерево Node. Массивы и словари выделяются из resource.
+// Ключи словарей проходят через таблицу keys, а если она не задана —
+// через собственную таблицу строителя.
+class DomBuilder {
+public:
+    explicit DomBuilder(std::pmr::memory_resource* resource = std::pmr::get_default_resource(),
+                        KeyTable* keys = nullptr)
+        : resource_(resource)
+        , keys_(keys != nullptr ? keys : &own_keys_) {
+    }
+
+    DomBuilder(const DomBuilder&) = delete;
+    DomBuilder& operator=(const DomBuilder&) = delete;
+
+    void Null() { Add(Node(nullptr)); }
+    void Bool(bool value) { Add(Node(value)); }
+    void Int(int value) { Add(Node(value)); }
+    void Int64(int64_t value) { Add(Node(value)); }
+    void Uint64(uint64_t value) { Add(Node(value)); }
+    void Double(double value) { Add(Node(value)); }
+    void String(std::string_view value) {
+        Add(IsBorrowed(value) ? Node::BorrowString(value) : Node(std::string(value)));
+    }
+
+    void StartArray() { stack_.push_back(Frame{Array(resource_), Members(resource_), {}, false}); }
+    void StartObject() { stack_.push_back(Frame{Array(resource_), Members(resource_), {}, true}); }
+    void Key(std::string_view key) { stack_.back().key = InternKey(key); }
+
+    void EndArray() {
+        Node node(std::move(stack_.back().array));
+        stack_.pop_back();
+        AddContainer(std::move(node));
+    }
+
+    void EndObject() {
+        Node node(Dict::FromUnordered(std::move(stack_.back().members)));
+        stack_.pop_back();
+        AddContainer(std::move(node));
+    }
+
+    Symbol InternKey(std::string_view key) { return keys_->Intern(key); }
+
+    // Строки, целиком лежащие в input, будут ссылаться на него без копирования
+    void BorrowStringsFrom(std::string_view input) { borrowed_ = input; }
+
+    // Вложенные контейнеры будут разделяться через subtrees; корень остаётся своим
+    void DeduplicateWith(SubtreeTable* subtrees) { subtrees_ = subtrees; }
+
+    // Забирает построенное значение; строитель можно использовать повторно
+    Node ExtractRoot() {
+        Node root = std::move(root_);
+        root_ = nullptr;
+        return root;
+    }
+
+private:
+    // Элементы словаря копятся в порядке текста и сортируются один раз
+    // в EndObject: вставка каждого ключа по месту стоила бы O(n) на ключ
+    using Members = std::pmr::vector<Dict::value_type>;
+
+    // Незавершённый контейнер и ключ, ожидающий значения
+    struct Frame {
+        Array array;
+        Members members;
+        Symbol key;
+        bool is_dict;
+    };
+
+    bool IsBorrowed(std::string_view value) const {
+        const std::less_equal<const char*> less_equal;
+        return borrowed_.data() != nullptr && less_equal(borrowed_.data(), value.data())
+            && less_equal(value.data() + value.size(), borrowed_.data() + borrowed_.size());
+    }
+
+    void AddContainer(Node node) {
+        if (subtrees_ != nullptr && !stack_.empty()) {
+            node = subtrees_->Intern(std::move(node));
+        }
+        Add(std::move(node));
+    }
+
+    void Add(Node node) {
+        if (stack_.empty()) {
+            root_ = std::move(node);
+            return;
+        }
+        Frame& top = stack_.back();
+        if (top.is_dict) {
+            top.members.emplace_back(std::move(top.key), std::move(node));
+        } else {
+            top.array.push_back(std::move(node));
+        }
+    }
+
+    std::pmr::memory_resource* resource_;
+    KeyTable own_keys_;
+    KeyTable* keys_;
+    std::string_view borrowed_;
+    SubtreeTable* subtrees_ = nullptr;
+    std::vector<Frame> stack_;
+    Node root_;
+};
+
+inline std::unique_ptr<Document::Arena> MakeArena(const LoadOptions& options, size_t arena_size) {
+    return options.use_arena && !options.deduplicate ? std::make_unique<Document::Arena>(arena_size) : nullptr;
+}
+
+// Загружает документ из буфера или потока. При whole_input за значением
+// допускаются только пробельные символы. Таблицу ключей keys можно
+// разделить между несколькими загрузками подряд.
+template <typename Input>
+Document LoadDocument(Input& input, const LoadOptions& options, size_t arena_size, bool whole_input = false,
+                      KeyTable* keys = nullptr) {
+    std::unique_ptr<Document::Arena> arena = MakeArena(options, arena_size);
+    DomBuilder builder(arena ? arena.get() : std::pmr::get_default_resource(), keys);
+    SubtreeTable subtrees;
+    if (options.deduplicate) {
+        builder.DeduplicateWith(&subtrees);
+    }
+    if constexpr (std::is_same_v<Input, std::string_view>) {
+        if (options.borrow_strings) {
+            builder.BorrowStringsFrom(input);
+        }
+    }
+    Parser parser(input, builder);
+    parser.ParseValue();
+    if (whole_input && parser.SkipWhitespace()) {
+        throw ParsingError("Unexpected data after JSON value");
+    }
+    Node root = builder.ExtractRoot();
+    return arena ? Document{std::move(root), std::move(arena)} : Document{std::move(root)};
+}
+
+// Загружает документ из text, лежащего внутри owner. Документ держит owner,
+// только если его строки ссылаются на text (options.borrow_strings).
+inline Document LoadOwnedBuffer(std::string_view text, std::shared_ptr<const void> owner,
+                                const LoadOptions& options, size_t arena_size) {
+    std::unique_ptr<Document::Arena> arena = MakeArena(options, arena_size);
+    DomBuilder builder(arena ? arena.get() : std::pmr::get_default_resource());
+    SubtreeTable subtrees;
+    if (options.deduplicate) {
+        builder.DeduplicateWith(&subtrees);
+    }
+    if (options.borrow_strings) {
+        builder.BorrowStringsFrom(text);
+    }
+    Parser parser(text, builder);
+    parser.ParseValue();
+    if (!options.borrow_strings) {
+        owner.reset();
+    }
+    return Document{builder.ExtractRoot(), std::move(arena), std::move(owner)};
+}
+
+// Сообщает обработчику о содержимом готового дерева в том же порядке,
+// в каком о нём сообщил бы парсер
+template <typename Handler>
+void EmitEvents(const Node& node, Handler& handler) {
+    if (node.IsNull()) {
+        handler.Null();
+    } else if (node.IsBool()) {
+        handler.Bool(node.AsBool());
+    } else if (node.IsInt()) {
+        handler.Int(node.AsInt());
+    } else if (node.IsInt64()) {
+        handler.Int64(node.AsInt64());
+    } else if (node.IsUint64()) {
+        handler.Uint64(node.AsUint64());
+    } else if (node.IsPureDouble()) {
+        handler.Double(node.AsDouble());
+    } else if (node.IsString()) {
+        handler.String(node.AsString());
+    } else if (node.IsArray()) {
+        handler.StartArray();
+        for (const Node& item : node.AsArray()) {
+            EmitEvents(item, handler);
+        }
+        handler.EndArray();
+    } else {
+        handler.StartObject();
+        for (const auto& [key, value] : node.AsMap()) {
+            handler.Key(key);
+            EmitEvents(value, handler);
+        }
+        handler.EndObject();
+    }
+}
+
+}  // namespace json::detail
@@ -0,0 +1,309 @@
+#include "json_path.h"
+#include "json_parser.h"
+
+#include <algorithm>
+#include <charconv>
+
+using namespace std;
+
+namespace json {
+
+namespace {
+
+// Число из одних цифр без ведущих нулей, как требует RFC 6901 для индекса
+bool ParseIndex(string_view text, size_t& value) {
+    if (text.empty() || (text.size() > 1 && text.front() == '0')
+        || !all_of(text.begin(), text.end(), detail::IsDigit)) {
+        return false;
+    }
+    return from_chars(text.data(), text.data() + text.size(), value).ec == errc{};
+}
+
+}  // namespace
+
+// Обработчик событий разбора, который строит только значения, отвечающие
+// пути. Для каждого открытого контейнера помнит, лежит ли он на пути.
+class PathCollector {
+public:
+    explicit PathCollector(const Path& path)
+        : path_(path) {
+    }
+
+    void Null() {
+        Scalar([this] {
+            builder_.Null();
+        });
+    }
+    void Bool(bool value) {
+        Scalar([this, value] {
+            builder_.Bool(value);
+        });
+    }
+    void Int(int value) {
+        Scalar([this, value] {
+            builder_.Int(value);
+        });
+    }
+    void Int64(int64_t value) {
+        Scalar([this, value] {
+            builder_.Int64(value);
+        });
+    }
+    void Uint64(uint64_t value) {
+        Scalar([this, value] {
+            builder_.Uint64(value);
+        });
+    }
+    void Double(double value) {
+        Scalar([this, value] {
+            builder_.Double(value);
+        });
+    }
+    void String(string_view value) {
+        Scalar([this, value] {
+            builder_.String(value);
+        });
+    }
+
+    void StartArray() {
+        StartContainer(false, [this] {
+            builder_.StartArray();
+        });
+    }
+    void StartObject() {
+        StartContainer(true, [this] {
+            builder_.StartObject();
+        });
+    }
+
+    void Key(string_view key) {
+        if (capture_depth_ > 0) {
+            builder_.Key(key);
+        } else if (frames_.back().on_path) {
+            frames_.back().key.assign(key);
+        }
+    }
+
+    void EndArray() {
+        EndContainer([this] {
+            builder_.EndArray();
+        });
+    }
+    void EndObject() {
+        EndContainer([this] {
+            builder_.EndObject();
+        });
+    }
+
+    vector<Node> ExtractResults() { return move(results_); }
+
+private:
+    enum class Match { None, Prefix, Full };
+
+    struct Frame {
+        bool is_dict;
+        // Контейнер отвечает первым шагам пути, число которых равно его глубине
+        bool on_path;
+        size_t index = 0;
+        string key;
+    };
+
+    // Положение очередного значения относительно пути
+    Match NextValue() {
+        const vector<Path::Step>& steps = path_.steps_;
+        if (frames_.empty()) {
+            return steps.empty() ? Match::Full : Match::Prefix;
+        }
+        Frame& top = frames_.back();
+        const size_t index = top.is_dict ? 0 : top.index++;
+        if (!top.on_path) {
+            return Match::None;
+        }
+        const size_t depth = frames_.size() - 1;
+        const Path::Step& step = steps[depth];
+        const bool matches = top.is_dict ? step.kind == Path::Step::Kind::Wildcard || step.key.View() == top.key
+                                         : step.MatchesIndex(index);
+        if (!matches) {
+            return Match::None;
+        }
+        return depth + 1 == steps.size() ? Match::Full : Match::Prefix;
+    }
+
+    template <typename Emit>
+    void Scalar(Emit emit) {
+        if (capture_depth_ > 0) {
+            emit();
+        } else if (NextValue() == Match::Full) {
+            emit();
+            results_.push_back(builder_.ExtractRoot());
+        }
+    }
+
+    template <typename Emit>
+    void StartContainer(bool is_dict, Emit emit) {
+        if (capture_depth_ > 0) {
+            ++capture_depth_;
+            emit();
+            return;
+        }
+        const Match match = NextValue();
+        if (match == Match::Full) {
+            capture_depth_ = 1;
+            emit();
+            return;
+        }
+        // Контейнер вне пути всё равно отслеживается, чтобы знать его конец
+        frames_.push_back(Frame{is_dict, match == Match::Prefix, 0, {}});
+    }
+
+    template <typename Emit>
+    void EndContainer(Emit emit) {
+        if (capture_depth_ == 0) {
+            frames_.pop_back();
+            return;
+        }
+        emit();
+        if (--capture_depth_ == 0) {
+            results_.push_back(builder_.ExtractRoot());
+        }
+    }
+
+    const Path& path_;
+    vector<Frame> frames_;
+    // Глубина вложенности внутри строящегося совпадения; 0 — вне совпадения
+    size_t capture_depth_ = 0;
+    detail::DomBuilder builder_;
+    vector<Node> results_;
+};
+
+bool Path::Step::MatchesIndex(size_t i) const {
+    switch (kind) {
+    case Kind::Wildcard: return true;
+    case Kind::Slice: return i >= begin && i < end;
+    default: return i == index;
+    }
+}
+
+Path::Path(string_view expression)
+    : expression_(expression) {
+    if (expression.empty()) {
+        return;
+    }
+    if (expression.front() != '/') {
+        throw ParsingError("JSON pointer must start with '/': "s + expression_);
+    }
+    size_t pos = 1;
+    while (true) {
+        const size_t slash = expression.find('/', pos);
+        steps_.push_back(ParseStep(expression.substr(pos, slash == string_view::npos ? slash : slash - pos)));
+        if (slash == string_view::npos) {
+            break;
+        }
+        pos = slash + 1;
+    }
+}
+
+Path::Step Path::ParseStep(string_view token) {
+    string text;
+    text.reserve(token.size());
+    for (size_t i = 0; i < token.size(); ++i) {
+        if (token[i] != '~') {
+            text.push_back(token[i]);
+        } else if (i + 1 < token.size() && (token[i + 1] == '0' || token[i + 1] == '1')) {
+            text.push_back(token[++i] == '0' ? '~' : '/');
+        } else {
+            throw ParsingError("Invalid escape sequence in JSON pointer token: "s + string(token));
+        }
+    }
+
+    Step step;
+    step.key = json::Key(text);
+    if (token == "*"sv) {
+        step.kind = Step::Kind::Wildcard;
+        return step;
+    }
+    if (ParseIndex(text, step.index)) {
+        return step;
+    }
+    step.index = kNoIndex;
+    if (const size_t colon = text.find(':'); colon != string::npos && text.find(':', colon + 1) == string::npos) {
+        const string_view first = string_view(text).substr(0, colon);
+        const string_view last = string_view(text).substr(colon + 1);
+        if ((first.empty() || ParseIndex(first, step.begin)) && (last.empty() || ParseIndex(last, step.end))) {
+            step.kind = Step::Kind::Slice;
+        } else {
+            step.begin = 0;
+            step.end = kNoIndex;
+        }
+    }
+    return step;
+}
+
+template <typename Fn>
+bool Path::Visit(const Node& node, size_t depth, Fn& fn) const {
+    if (depth == steps_.size()) {
+        return fn(node);
+    }
+    const Step& step = steps_[depth];
+    if (node.IsMap()) {
+        const Dict& dict = node.AsMap();
+        if (step.kind == Step::Kind::Wildcard) {
+            for (const auto& [key, value] : dict) {
+                if (!Visit(value, depth + 1, fn)) {
+                    return false;
+                }
+            }
+        } else if (const auto it = dict.find(step.key); it != dict.end()) {
+            return Visit(it->second, depth + 1, fn);
+        }
+    } else if (node.IsArray()) {
+        const Array& array = node.AsArray();
+        if (step.kind == Step::Kind::Member) {
+            return step.index < array.size() ? Visit(array[step.index], depth + 1, fn) : true;
+        }
+        const size_t begin = step.kind == Step::Kind::Slice ? step.begin : 0;
+        const size_t end = step.kind == Step::Kind::Slice ? min(step.end, array.size()) : array.size();
+        for (size_t i = begin; i < end; ++i) {
+            if (!Visit(array[i], depth + 1, fn)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+vector<const Node*> Path::Select(const Node& root) const {
+    vector<const Node*> result;
+    auto collect = [&result](const Node& node) {
+        result.push_back(&node);
+        return true;
+    };
+    Visit(root, 0, collect);
+    return result;
+}
+
+const Node* Path::Find(const Node& root) const {
+    const Node* result = nullptr;
+    auto stop = [&result](const Node& node) {
+        result = &node;
+        return false;
+    };
+    Visit(root, 0, stop);
+    return result;
+}
+
+vector<Node> Path::Extract(string_view input) const {
+    PathCollector collector(*this);
+    detail::Parser parser(input, collector);
+    parser.ParseValue();
+    return collector.ExtractResults();
+}
+
+vector<Node> Path::Extract(istream& input) const {
+    PathCollector collector(*this);
+    detail::Parser parser(input, collector);
+    parser.ParseValue();
+    return collector.ExtractResults();
+}
+
+}  // namespace json
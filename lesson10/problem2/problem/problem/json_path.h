@@ -0,0 +1,78 @@
+#pragma once
+
+#include "json.h"
+
+#include <cstddef>
+#include <iosfwd>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace json {
+
+// Путь к значениям документа, разобранный один раз для многократного
+// применения. Синтаксис — JSON Pointer (RFC 6901): "" обозначает корень,
+// "/a/3/b" — шаги через '/', "~1" и "~0" в шаге означают '/' и '~'.
+// Расширения:
+//   "*"      — любой элемент массива или любое значение словаря;
+//   "2:5"    — срез массива, элементы с индексами 2, 3 и 4; любая
+//              из границ может отсутствовать: ":5", "2:", ":".
+// Шаг применяется в зависимости от типа значения: в словаре "3" и "2:5" —
+// обычные ключи, в массиве — индекс и срез. Шаг "*" всегда подстановка.
+//
+//     const json::Path path("/records/*/price"sv);
+//     for (const Document& doc : docs) {
+//         for (const Node* price : path.Select(doc.GetRoot())) { ... }
+//     }
+class Path {
+public:
+    // Выбрасывает ParsingError, если выражение некорректно
+    explicit Path(std::string_view expression);
+
+    // Все значения, отвечающие пути, в порядке обхода. Указатели
+    // действительны, пока жив root.
+    std::vector<const Node*> Select(const Node& root) const;
+    // Первое совпадение либо nullptr
+    const Node* Find(const Node& root) const;
+
+    // Разбирает текст, строя только совпавшие поддеревья. Значения идут
+    // в порядке текста, поэтому подстановка в словаре перечисляет их
+    // в порядке ключей в тексте, а не по возрастанию, как Select.
+    // Повторяющийся ключ словаря тоже расходится с Select: Load оставляет
+    // последнее значение, а Extract возвращает совпадения для каждого
+    // вхождения ключа.
+    std::vector<Node> Extract(std::string_view input) const;
+    std::vector<Node> Extract(std::istream& input) const;
+
+    const std::string& GetExpression() const { return expression_; }
+
+private:
+    friend class PathCollector;
+
+    struct Step {
+        enum class Kind { Member, Wildcard, Slice };
+
+        Kind kind = Kind::Member;
+        // Ключ словаря для шага Member
+        Key key{std::string_view{}};
+        // Индекс массива, если шаг Member записан как индекс по RFC 6901
+        size_t index = kNoIndex;
+        // Срез [begin, end) для шага Slice
+        size_t begin = 0;
+        size_t end = kNoIndex;
+
+        bool MatchesIndex(size_t i) const;
+    };
+
+    static constexpr size_t kNoIndex = std::numeric_limits<size_t>::max();
+
+    static Step ParseStep(std::string_view token);
+    template <typename Fn>
+    bool Visit(const Node& node, size_t depth, Fn& fn) const;
+
+    std::string expression_;
+    std::vector<Step> steps_;
+};
+
+}  // namespace json
@@ -0,0 +1,437 @@
+#include "json_push.h"
+#include "json_parser.h"
+
+#include <optional>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace json {
+
+namespace {
+
+bool IsNumberChar(char c) {
+    return detail::IsDigit(c) || c == '-' || c == '+' || c == '.' || c == 'e' || c == 'E';
+}
+
+bool IsLiteralChar(char c) {
+    return c >= 'a' && c <= 'z';
+}
+
+// Разбор без рекурсии: вложенность хранится в стеке состояний, поэтому
+// его можно прервать на любом символе и продолжить со следующей частью.
+// Незавершённый токен копится в pending_.
+template <typename Handler>
+class PushMachine {
+public:
+    explicit PushMachine(Handler& handler)
+        : handler_(handler) {
+    }
+
+    void Feed(string_view chunk) {
+        pos_ = chunk.data();
+        end_ = chunk.data() + chunk.size();
+        if (token_ != Token::None && !ResumeToken()) {
+            return;
+        }
+        Run();
+    }
+
+    void Finish() {
+        // Число и литерал в конце входа завершаются сами
+        if (token_ == Token::String) {
+            throw ParsingError("String parsing error");
+        }
+        if (token_ != Token::None) {
+            const Token token = exchange(token_, Token::None);
+            CompleteToken(token, pending_);
+        }
+        if (!started_ || !stack_.empty()) {
+            throw ParsingError("Unexpected end of input");
+        }
+    }
+
+private:
+    // Что ожидается внутри контейнера на вершине стека
+    enum class State : uint8_t {
+        ArrayFirst,
+        ArrayValue,
+        ArrayNext,
+        DictFirst,
+        DictKey,
+        DictColon,
+        DictValue,
+        DictNext,
+    };
+
+    // Токен, прерванный концом части
+    enum class Token : uint8_t { None, String, Number, Literal };
+
+    void Run() {
+        while (true) {
+            pos_ = detail::SkipWhitespace(pos_, end_);
+            if (pos_ == end_) {
+                return;
+            }
+            const char c = *pos_;
+            if (stack_.empty()) {
+                if (started_) {
+                    throw ParsingError("Unexpected data after JSON value");
+                }
+                started_ = true;
+                if (!StartValue(c)) {
+                    return;
+                }
+                continue;
+            }
+            // Состояние родителя меняется до начала значения: ссылка
+            // на вершину стека не переживает вложенный контейнер
+            State& state = stack_.back();
+            switch (state) {
+            case State::ArrayFirst:
+                if (c == ']') {
+                    ++pos_;
+                    EndArray();
+                    continue;
+                }
+                [[fallthrough]];
+            case State::ArrayValue:
+                state = State::ArrayNext;
+                if (!StartValue(c)) {
+                    return;
+                }
+                break;
+            case State::ArrayNext:
+                ++pos_;
+                if (c == ',') {
+                    state = State::ArrayValue;
+                } else if (c == ']') {
+                    EndArray();
+                } else {
+                    throw ParsingError("Expected ',' or ']' in array");
+                }
+                break;
+            case State::DictFirst:
+                if (c == '}') {
+                    ++pos_;
+                    EndObject();
+                    continue;
+                }
+                [[fallthrough]];
+            case State::DictKey:
+                if (c != '"') {
+                    throw ParsingError("Dictionary key must be string");
+                }
+                state = State::DictColon;
+                ++pos_;
+                if (!StartString(true)) {
+                    return;
+                }
+                break;
+            case State::DictColon:
+                if (c != ':') {
+                    throw ParsingError("Expected ':' after dictionary key");
+                }
+                ++pos_;
+                state = State::DictValue;
+                break;
+            case State::DictValue:
+                state = State::DictNext;
+                if (!StartValue(c)) {
+                    return;
+                }
+                break;
+            case State::DictNext:
+                ++pos_;
+                if (c == ',') {
+                    state = State::DictKey;
+                } else if (c == '}') {
+                    EndObject();
+                } else {
+                    throw ParsingError("Expected ',' or '}' in dictionary");
+                }
+                break;
+            }
+        }
+    }
+
+    // Начинает значение с символа c. Возвращает false, если токен
+    // прерван концом части
+    bool StartValue(char c) {
+        if (c == '[') {
+            ++pos_;
+            handler_.StartArray();
+            stack_.push_back(State::ArrayFirst);
+            return true;
+        }
+        if (c == '{') {
+            ++pos_;
+            handler_.StartObject();
+            stack_.push_back(State::DictFirst);
+            return true;
+        }
+        if (c == '"') {
+            ++pos_;
+            return StartString(false);
+        }
+        if (c == 'n' || c == 't' || c == 'f') {
+            return StartToken(Token::Literal);
+        }
+        if (detail::IsDigit(c) || c == '-') {
+            return StartToken(Token::Number);
+        }
+        throw ParsingError("Unexpected character: " + string(1, c));
+    }
+
+    void EndArray() {
+        stack_.pop_back();
+        handler_.EndArray();
+    }
+
+    void EndObject() {
+        stack_.pop_back();
+        handler_.EndObject();
+    }
+
+    bool StartString(bool is_key) {
+        is_key_ = is_key;
+        // Строка без экранирования, целиком лежащая в части, не копируется
+        const char* run = pos_;
+        const char* special = detail::FindStringSpecial(pos_, end_);
+        if (special != end_ && *special == '"') {
+            pos_ = special + 1;
+            EmitString(string_view(run, static_cast<size_t>(special - run)));
+            return true;
+        }
+        pending_.clear();
+        token_ = Token::String;
+        return ContinueString();
+    }
+
+    // Дописывает в pending_ содержимое строки до закрывающей кавычки
+    bool ContinueString() {
+        using namespace std::literals;
+
+        while (true) {
+            if (escaped_) {
+                if (pos_ == end_) {
+                    return false;
+                }
+                escaped_ = false;
+                const char escaped_char = *pos_++;
+                switch (escaped_char) {
+                case 'n': pending_.push_back('\n'); break;
+                case 't': pending_.push_back('\t'); break;
+                case 'r': pending_.push_back('\r'); break;
+                case '"': pending_.push_back('"'); break;
+                case '\\': pending_.push_back('\\'); break;
+                default: throw ParsingError("Unrecognized escape sequence \\"s + escaped_char);
+                }
+            }
+            const char* run = pos_;
+            pos_ = detail::FindStringSpecial(pos_, end_);
+            pending_.append(run, pos_);
+            if (pos_ == end_) {
+                return false;
+            }
+            const char ch = *pos_++;
+            if (ch == '"') {
+                token_ = Token::None;
+                EmitString(pending_);
+                return true;
+            } else if (ch == '\\') {
+                escaped_ = true;
+            } else if (ch == '\n' || ch == '\r') {
+                throw ParsingError("Unexpected end of line"s);
+            } else {
+                // Прочие управляющие символы переносим в строку как есть
+                pending_.push_back(ch);
+            }
+        }
+    }
+
+    void EmitString(string_view value) {
+        if (is_key_) {
+            handler_.Key(value);
+        } else {
+            handler_.String(value);
+        }
+    }
+
+    // Число и литерал кончаются на первом символе, который не может
+    // им принадлежать, поэтому в конце части они ещё не завершены
+    bool StartToken(Token token) {
+        const char* start = pos_;
+        pos_ = SkipTokenChars(token);
+        if (pos_ == end_) {
+            pending_.assign(start, pos_);
+            token_ = token;
+            return false;
+        }
+        CompleteToken(token, string_view(start, static_cast<size_t>(pos_ - start)));
+        return true;
+    }
+
+    const char* SkipTokenChars(Token token) const {
+        const char* pos = pos_;
+        if (token == Token::Number) {
+            while (pos != end_ && IsNumberChar(*pos)) {
+                ++pos;
+            }
+        } else {
+            while (pos != end_ && IsLiteralChar(*pos)) {
+                ++pos;
+            }
+        }
+        return pos;
+    }
+
+    // Продолжает токен, прерванный прошлой частью
+    bool ResumeToken() {
+        if (token_ == Token::String) {
+            return ContinueString();
+        }
+        const char* start = pos_;
+        pos_ = SkipTokenChars(token_);
+        pending_.append(start, pos_);
+        if (pos_ == end_) {
+            return false;
+        }
+        CompleteToken(exchange(token_, Token::None), pending_);
+        return true;
+    }
+
+    void CompleteToken(Token token, string_view text) {
+        if (token == Token::Number) {
+            CompleteNumber(text);
+        } else if (text == "null"sv) {
+            handler_.Null();
+        } else if (text == "true"sv) {
+            handler_.Bool(true);
+        } else if (text == "false"sv) {
+            handler_.Bool(false);
+        } else {
+            throw ParsingError("Invalid literal: " + string(text));
+        }
+    }
+
+    // Проверяет число по грамматике JSON, как Parser::ParseNumber
+    void CompleteNumber(string_view text) {
+        size_t i = 0;
+        const auto read_digits = [&text, &i] {
+            const size_t begin = i;
+            while (i < text.size() && detail::IsDigit(text[i])) {
+                ++i;
+            }
+            if (i == begin) {
+                throw ParsingError("A digit is expected");
+            }
+        };
+
+        if (text[i] == '-') {
+            ++i;
+        }
+        if (i < text.size() && text[i] == '0') {
+            ++i;
+        } else {
+            read_digits();
+        }
+
+        bool is_int = true;
+        if (i < text.size() && text[i] == '.') {
+            ++i;
+            read_digits();
+            is_int = false;
+        }
+        if (i < text.size() && (text[i] == 'e' || text[i] == 'E')) {
+            ++i;
+            if (i < text.size() && (text[i] == '+' || text[i] == '-')) {
+                ++i;
+            }
+            read_digits();
+            is_int = false;
+        }
+        if (i != text.size()) {
+            throw ParsingError("Invalid number: " + string(text));
+        }
+        detail::EmitNumber(text.data(), text.data() + text.size(), is_int, handler_);
+    }
+
+    Handler& handler_;
+    vector<State> stack_;
+    const char* pos_ = nullptr;
+    const char* end_ = nullptr;
+    // Значение верхнего уровня уже началось
+    bool started_ = false;
+
+    Token token_ = Token::None;
+    // Строка ожидает ключ словаря; последним символом части был '\'
+    bool is_key_ = false;
+    bool escaped_ = false;
+    // Прочитанная часть токена; у строки — уже без экранирования
+    string pending_;
+};
+
+}  // namespace
+
+// Парсер работает либо с внешним обработчиком, либо со строителем документа
+struct PushParser::Impl {
+    explicit Impl(Handler& handler) {
+        sax.emplace(handler);
+    }
+
+    explicit Impl(const LoadOptions& options)
+        // Размер входа заранее неизвестен: арена растёт от блока, как при чтении потока
+        : arena(detail::MakeArena(options, size_t{1} << 16))
+        , builder(arena ? arena.get() : pmr::get_default_resource()) {
+        if (options.deduplicate) {
+            builder.DeduplicateWith(&subtrees);
+        }
+        dom.emplace(builder);
+    }
+
+    unique_ptr<Document::Arena> arena;
+    detail::SubtreeTable subtrees;
+    detail::DomBuilder builder;
+    optional<PushMachine<Handler>> sax;
+    optional<PushMachine<detail::DomBuilder>> dom;
+    bool finished = false;
+};
+
+PushParser::PushParser(Handler& handler)
+    : impl_(make_unique<Impl>(handler)) {
+}
+
+PushParser::PushParser(const LoadOptions& options)
+    : impl_(make_unique<Impl>(options)) {
+}
+
+PushParser::~PushParser() = default;
+
+void PushParser::Feed(string_view chunk) {
+    if (impl_->sax) {
+        impl_->sax->Feed(chunk);
+    } else {
+        impl_->dom->Feed(chunk);
+    }
+}
+
+void PushParser::Finish() {
+    if (impl_->sax) {
+        impl_->sax->Finish();
+    } else {
+        impl_->dom->Finish();
+    }
+    impl_->finished = true;
+}
+
+Document PushParser::TakeDocument() {
+    if (!impl_->dom || !impl_->finished) {
+        throw logic_error("No document to take");
+    }
+    Node root = impl_->builder.ExtractRoot();
+    return Document{move(root), move(impl_->arena)};
+}
+
+}  // namespace json
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "json.h"
+#include "json_sax.h"
+
+#include <memory>
+#include <string_view>
+
+namespace json {
+
+// Разбор входа, который приходит частями произвольного размера, например
+// из сети. Парсер не ждёт конца документа: каждая часть разбирается сразу,
+// а состояние, в том числе строка или число на границе частей, переносится
+// до следующего вызова Feed. Вход не накапливается: в памяти держится
+// только незавершённый токен.
+//
+//     json::PushParser parser;
+//     while (receive(chunk)) {
+//         parser.Feed(chunk);
+//     }
+//     parser.Finish();
+//     const json::Document doc = parser.TakeDocument();
+//
+// После ParsingError разбор продолжить нельзя.
+class PushParser {
+public:
+    // События разбора получает handler по мере поступления частей
+    explicit PushParser(Handler& handler);
+    // Разбор строит документ. Строки всегда копируются: части входа
+    // не переживают вызов Feed, поэтому borrow_strings не действует.
+    explicit PushParser(const LoadOptions& options = {});
+    ~PushParser();
+
+    PushParser(const PushParser&) = delete;
+    PushParser& operator=(const PushParser&) = delete;
+
+    // Разбирает очередную часть. Данные после значения — ParsingError.
+    void Feed(std::string_view chunk);
+    // Сообщает, что вход закончился. ParsingError, если значение не завершено.
+    void Finish();
+
+    // Построенный документ. Доступен после Finish у парсера без обработчика,
+    // иначе std::logic_error.
+    Document TakeDocument();
+
+private:
+    struct Impl;
+
+    std::unique_ptr<Impl> impl_;
+};
+
+}  // namespace json
@@ -0,0 +1,18 @@
+#include "json_sax.h"
+#include "json_parser.h"
+
+using namespace std;
+
+namespace json {
+
+void Parse(string_view input, Handler& handler) {
+    detail::Parser parser(input, handler);
+    parser.ParseValue();
+}
+
+void Parse(istream& input, Handler& handler) {
+    detail::Parser parser(input, handler);
+    parser.ParseValue();
+}
+
+}  // namespace json
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstdint>
+#include <iosfwd>
+#include <string_view>
+
+namespace json {
+
+// Обработчик событий потокового (SAX) разбора. Дерево Node не строится:
+// парсер сообщает о каждом значении по мере чтения, поэтому расход памяти
+// определяется глубиной вложенности, а не размером документа.
+// Переданные string_view действительны только на время вызова.
+class Handler {
+public:
+    virtual ~Handler() = default;
+
+    virtual void Null() = 0;
+    virtual void Bool(bool value) = 0;
+    virtual void Int(int value) = 0;
+    // Целые, не помещающиеся в int. Реализации по умолчанию нет: переход
+    // к double молча округлял бы значения больше 2^53, а дерево Node их
+    // хранит точно
+    virtual void Int64(int64_t value) = 0;
+    virtual void Uint64(uint64_t value) = 0;
+    virtual void Double(double value) = 0;
+    virtual void String(std::string_view value) = 0;
+
+    virtual void StartArray() = 0;
+    virtual void EndArray() = 0;
+
+    virtual void StartObject() = 0;
+    // Ключ очередной пары; следом приходят события её значения
+    virtual void Key(std::string_view key) = 0;
+    virtual void EndObject() = 0;
+};
+
+// Разбирает одно значение JSON, сообщая о нём обработчику.
+// Поток читается блоками и не накапливается в памяти целиком.
+void Parse(std::string_view input, Handler& handler);
+void Parse(std::istream& input, Handler& handler);
+
+}  // namespace json
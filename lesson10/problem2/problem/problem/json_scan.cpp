@@ -0,0 +1,269 @@
+#include "json_scan.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define JSON_SCAN_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+#if defined(JSON_SCAN_X86) && (defined(__GNUC__) || defined(__clang__))
+#define JSON_TARGET_SSE2 __attribute__((target("sse2")))
+#define JSON_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define JSON_TARGET_SSE2
+#define JSON_TARGET_AVX2
+#endif
+
+namespace json::detail {
+
+namespace {
+
+using ScanFn = const char* (*)(const char*, const char*);
+
+bool IsSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+bool IsStringSpecial(char c) {
+    return c == '"' || c == '\\' || static_cast<unsigned char>(c) < 0x20;
+}
+
+bool IsStructural(char c) {
+    return c == '"' || c == '[' || c == ']' || c == '{' || c == '}';
+}
+
+const char* SkipWhitespaceScalar(const char* pos, const char* end) {
+    while (pos != end && IsSpace(*pos)) {
+        ++pos;
+    }
+    return pos;
+}
+
+const char* FindStringSpecialScalar(const char* pos, const char* end) {
+    while (pos != end && !IsStringSpecial(*pos)) {
+        ++pos;
+    }
+    return pos;
+}
+
+const char* FindStructuralScalar(const char* pos, const char* end) {
+    while (pos != end && !IsStructural(*pos)) {
+        ++pos;
+    }
+    return pos;
+}
+
+#ifdef JSON_SCAN_X86
+
+int CountTrailingZeros(unsigned mask) {
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return static_cast<int>(index);
+#else
+    return __builtin_ctz(mask);
+#endif
+}
+
+JSON_TARGET_SSE2 const char* SkipWhitespaceSse2(const char* pos, const char* end) {
+    const __m128i space = _mm_set1_epi8(' ');
+    const __m128i tab = _mm_set1_epi8('\t');
+    const __m128i lf = _mm_set1_epi8('\n');
+    const __m128i cr = _mm_set1_epi8('\r');
+    while (end - pos >= 16) {
+        const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pos));
+        const __m128i ws = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(block, space), _mm_cmpeq_epi8(block, tab)),
+                                        _mm_or_si128(_mm_cmpeq_epi8(block, lf), _mm_cmpeq_epi8(block, cr)));
+        const unsigned mask = ~static_cast<unsigned>(_mm_movemask_epi8(ws)) & 0xFFFFu;
+        if (mask != 0) {
+            return pos + CountTrailingZeros(mask);
+        }
+        pos += 16;
+    }
+    return SkipWhitespaceScalar(pos, end);
+}
+
+JSON_TARGET_SSE2 const char* FindStringSpecialSse2(const char* pos, const char* end) {
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i control_max = _mm_set1_epi8(0x1F);
+    while (end - pos >= 16) {
+        const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pos));
+        // x <= 0x1F без знака <=> max(x, 0x1F) == 0x1F
+        const __m128i control = _mm_cmpeq_epi8(_mm_max_epu8(block, control_max), control_max);
+        const __m128i special = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(block, quote), _mm_cmpeq_epi8(block, backslash)), control);
+        const unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(special));
+        if (mask != 0) {
+            return pos + CountTrailingZeros(mask);
+        }
+        pos += 16;
+    }
+    return FindStringSpecialScalar(pos, end);
+}
+
+JSON_TARGET_SSE2 const char* FindStructuralSse2(const char* pos, const char* end) {
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i open_bracket = _mm_set1_epi8('[');
+    const __m128i close_bracket = _mm_set1_epi8(']');
+    const __m128i open_brace = _mm_set1_epi8('{');
+    const __m128i close_brace = _mm_set1_epi8('}');
+    while (end - pos >= 16) {
+        const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pos));
+        const __m128i brackets = _mm_or_si128(_mm_cmpeq_epi8(block, open_bracket), _mm_cmpeq_epi8(block, close_bracket));
+        const __m128i braces = _mm_or_si128(_mm_cmpeq_epi8(block, open_brace), _mm_cmpeq_epi8(block, close_brace));
+        const __m128i structural = _mm_or_si128(_mm_or_si128(brackets, braces), _mm_cmpeq_epi8(block, quote));
+        const unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(structural));
+        if (mask != 0) {
+            return pos + CountTrailingZeros(mask);
+        }
+        pos += 16;
+    }
+    return FindStructuralScalar(pos, end);
+}
+
+JSON_TARGET_AVX2 const char* SkipWhitespaceAvx2(const char* pos, const char* end) {
+    const __m256i space = _mm256_set1_epi8(' ');
+    const __m256i tab = _mm256_set1_epi8('\t');
+    const __m256i lf = _mm256_set1_epi8('\n');
+    const __m256i cr = _mm256_set1_epi8('\r');
+    while (end - pos >= 32) {
+        const __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pos));
+        const __m256i ws = _mm256_or_si256(
+            _mm256_or_si256(_mm256_cmpeq_epi8(block, space), _mm256_cmpeq_epi8(block, tab)),
+            _mm256_or_si256(_mm256_cmpeq_epi8(block, lf), _mm256_cmpeq_epi8(block, cr)));
+        const unsigned mask = ~static_cast<unsigned>(_mm256_movemask_epi8(ws));
+        if (mask != 0) {
+            return pos + CountTrailingZeros(mask);
+        }
+        pos += 32;
+    }
+    return SkipWhitespaceSse2(pos, end);
+}
+
+JSON_TARGET_AVX2 const char* FindStringSpecialAvx2(const char* pos, const char* end) {
+    const __m256i quote = _mm256_set1_epi8('"');
+    const __m256i backslash = _mm256_set1_epi8('\\');
+    const __m256i control_max = _mm256_set1_epi8(0x1F);
+    while (end - pos >= 32) {
+        const __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pos));
+        const __m256i control = _mm256_cmpeq_epi8(_mm256_max_epu8(block, control_max), control_max);
+        const __m256i special = _mm256_or_si256(
+            _mm256_or_si256(_mm256_cmpeq_epi8(block, quote), _mm256_cmpeq_epi8(block, backslash)), control);
+        const unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(special));
+        if (mask != 0) {
+            return pos + CountTrailingZeros(mask);
+        }
+        pos += 32;
+    }
+    return FindStringSpecialSse2(pos, end);
+}
+
+JSON_TARGET_AVX2 const char* FindStructuralAvx2(const char* pos, const char* end) {
+    const __m256i quote = _mm256_set1_epi8('"');
+    const __m256i open_bracket = _mm256_set1_epi8('[');
+    const __m256i close_bracket = _mm256_set1_epi8(']');
+    const __m256i open_brace = _mm256_set1_epi8('{');
+    const __m256i close_brace = _mm256_set1_epi8('}');
+    while (end - pos >= 32) {
+        const __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pos));
+        const __m256i brackets
+            = _mm256_or_si256(_mm256_cmpeq_epi8(block, open_bracket), _mm256_cmpeq_epi8(block, close_bracket));
+        const __m256i braces
+            = _mm256_or_si256(_mm256_cmpeq_epi8(block, open_brace), _mm256_cmpeq_epi8(block, close_brace));
+        const __m256i structural
+            = _mm256_or_si256(_mm256_or_si256(brackets, braces), _mm256_cmpeq_epi8(block, quote));
+        const unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(structural));
+        if (mask != 0) {
+            return pos + CountTrailingZeros(mask);
+        }
+        pos += 32;
+    }
+    return FindStructuralSse2(pos, end);
+}
+
+bool HasSse2() {
+#if defined(_M_X64) || defined(__x86_64__)
+    return true;
+#elif defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 1);
+    return (info[3] & (1 << 26)) != 0;
+#else
+    return __builtin_cpu_supports("sse2");
+#endif
+}
+
+bool HasAvx2() {
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) {
+        return false;
+    }
+    __cpuid(info, 1);
+    const bool os_saves_ymm = (info[2] & (1 << 27)) != 0 && (_xgetbv(0) & 0x6) == 0x6;
+    if (!os_saves_ymm) {
+        return false;
+    }
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+
+#endif  // JSON_SCAN_X86
+
+struct Kernels {
+    ScanFn skip_whitespace = SkipWhitespaceScalar;
+    ScanFn find_string_special = FindStringSpecialScalar;
+    ScanFn find_structural = FindStructuralScalar;
+};
+
+Kernels SelectKernels() {
+    Kernels kernels;
+#ifdef JSON_SCAN_X86
+    if (HasAvx2()) {
+        kernels.skip_whitespace = SkipWhitespaceAvx2;
+        kernels.find_string_special = FindStringSpecialAvx2;
+        kernels.find_structural = FindStructuralAvx2;
+    } else if (HasSse2()) {
+        kernels.skip_whitespace = SkipWhitespaceSse2;
+        kernels.find_string_special = FindStringSpecialSse2;
+        kernels.find_structural = FindStructuralSse2;
+    }
+#endif
+    return kernels;
+}
+
+const Kernels& GetKernels() {
+    static const Kernels kernels = SelectKernels();
+    return kernels;
+}
+
+}  // namespace
+
+const char* SkipWhitespace(const char* pos, const char* end) {
+    // Короткие промежутки (один пробел после ':' или ',') встречаются
+    // чаще всего, их выгоднее обработать без векторного ядра
+    if (pos == end || !IsSpace(*pos)) {
+        return pos;
+    }
+    if (++pos == end || !IsSpace(*pos)) {
+        return pos;
+    }
+    return GetKernels().skip_whitespace(pos, end);
+}
+
+const char* FindStringSpecial(const char* pos, const char* end) {
+    return GetKernels().find_string_special(pos, end);
+}
+
+const char* FindStructural(const char* pos, const char* end) {
+    return GetKernels().find_structural(pos, end);
+}
+
+}  // namespace json::detail
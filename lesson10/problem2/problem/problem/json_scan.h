@@ -0,0 +1,20 @@
+#pragma once
+
+namespace json::detail {
+
+// Векторные примитивы лексера. Реализация (SSE2/AVX2 или скалярная)
+// выбирается один раз при первом вызове по возможностям процессора.
+
+// Возвращает первый символ в [pos, end), не являющийся пробельным
+// символом JSON (' ', '\t', '\n', '\r'), либо end.
+const char* SkipWhitespace(const char* pos, const char* end);
+
+// Возвращает первый символ в [pos, end), требующий особой обработки
+// внутри строки: '"', '\\' или управляющий символ с кодом меньше 0x20.
+const char* FindStringSpecial(const char* pos, const char* end);
+
+// Возвращает первую кавычку или скобку ('[', ']', '{', '}') в [pos, end)
+// либо end. Нужна, чтобы перешагивать через значения, не разбирая их.
+const char* FindStructural(const char* pos, const char* end);
+
+}  // namespace json::detail
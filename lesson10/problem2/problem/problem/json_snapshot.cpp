@@ -0,0 +1,436 @@
+#include "json_snapshot.h"
+#include "json_file.h"
+
+#include <bit>
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <unordered_map>
+
+using namespace std;
+
+namespace json {
+
+// Образ читается на месте, без перестановки байтов
+static_assert(endian::native == endian::little, "Snapshot image requires a little-endian platform");
+
+namespace {
+
+constexpr string_view kMagic = "JSNS"sv;
+constexpr uint32_t kVersion = 1;
+
+// Заголовок: сигнатура, версия, размер образа, ячейка корня
+constexpr size_t kVersionOffset = 4;
+constexpr size_t kSizeOffset = 8;
+constexpr size_t kRootOffset = 16;
+constexpr size_t kHeaderSize = 32;
+
+// Ячейка: тег, 4 байта выравнивания и 8 байт данных
+constexpr size_t kSlotSize = 16;
+constexpr size_t kPayloadOffset = 8;
+// Запись словаря: смещение ключа и ячейка значения
+constexpr size_t kEntrySize = 8 + kSlotSize;
+
+enum Tag : uint32_t {
+    kNull,
+    kBool,
+    kInt,
+    kInt64,
+    kUint64,
+    kDouble,
+    kString,
+    kArray,
+    kDict,
+};
+
+[[noreturn]] void ThrowCorrupted() {
+    throw ParsingError("Snapshot is corrupted");
+}
+
+template <typename T>
+T Read(string_view image, size_t offset) {
+    if (offset > image.size() || image.size() - offset < sizeof(T)) {
+        ThrowCorrupted();
+    }
+    T value;
+    memcpy(&value, image.data() + offset, sizeof(T));
+    return value;
+}
+
+// Проверяет, что в образе есть count элементов по item_size байт начиная с offset
+void CheckRange(string_view image, size_t offset, uint64_t count, size_t item_size) {
+    if (offset > image.size() || count > (image.size() - offset) / item_size) {
+        ThrowCorrupted();
+    }
+}
+
+string_view ReadString(string_view image, size_t block) {
+    const uint64_t size = Read<uint64_t>(image, block);
+    CheckRange(image, block + 8, size, 1);
+    return image.substr(block + 8, static_cast<size_t>(size));
+}
+
+// Строит образ в памяти. Блок контейнера резервируется целиком до записи
+// его элементов, а ячейки заполняются по мере того, как становятся
+// известны смещения дочерних блоков.
+class ImageBuilder {
+public:
+    string Build(const Node& root) {
+        image_.assign(kHeaderSize, '\0');
+        memcpy(image_.data(), kMagic.data(), kMagic.size());
+        Write<uint32_t>(kVersionOffset, kVersion);
+        WriteSlot(kRootOffset, root);
+        Write<uint64_t>(kSizeOffset, image_.size());
+        return move(image_);
+    }
+
+private:
+    template <typename T>
+    void Write(size_t offset, T value) {
+        memcpy(image_.data() + offset, &value, sizeof(T));
+    }
+
+    // Выделяет в конце образа size байт, выровненных на 8
+    size_t Allocate(size_t size) {
+        const size_t offset = image_.size();
+        image_.resize(offset + (size + 7) / 8 * 8, '\0');
+        return offset;
+    }
+
+    size_t AddString(string_view text) {
+        const size_t block = Allocate(8 + text.size());
+        Write<uint64_t>(block, text.size());
+        memcpy(image_.data() + block + 8, text.data(), text.size());
+        return block;
+    }
+
+    size_t AddKey(string_view key) {
+        if (const auto it = keys_.find(key); it != keys_.end()) {
+            return it->second;
+        }
+        const size_t block = AddString(key);
+        keys_.emplace(key, block);
+        return block;
+    }
+
+    void WriteSlot(size_t slot, const Node& node) {
+        uint32_t tag = kNull;
+        uint64_t payload = 0;
+        switch (node.GetType()) {
+        case Node::Type::Null:
+            tag = kNull;
+            break;
+        case Node::Type::Bool:
+            tag = kBool;
+            payload = node.AsBool() ? 1 : 0;
+            break;
+        case Node::Type::Int:
+            tag = kInt;
+            payload = static_cast<uint64_t>(static_cast<int64_t>(node.AsInt()));
+            break;
+        case Node::Type::Int64:
+            tag = kInt64;
+            payload = static_cast<uint64_t>(node.AsInt64());
+            break;
+        case Node::Type::Uint64:
+            tag = kUint64;
+            payload = node.AsUint64();
+            break;
+        case Node::Type::Double:
+            tag = kDouble;
+            payload = bit_cast<uint64_t>(node.AsDouble());
+            break;
+        case Node::Type::String:
+            tag = kString;
+            payload = AddString(node.AsString());
+            break;
+        case Node::Type::Array: {
+            const Array& array = node.AsArray();
+            tag = kArray;
+            payload = Allocate(8 + array.size() * kSlotSize);
+            Write<uint64_t>(payload, array.size());
+            for (size_t i = 0; i < array.size(); ++i) {
+                WriteSlot(payload + 8 + i * kSlotSize, array[i]);
+            }
+            break;
+        }
+        case Node::Type::Dict: {
+            const Dict& dict = node.AsMap();
+            tag = kDict;
+            payload = Allocate(8 + dict.size() * kEntrySize);
+            Write<uint64_t>(payload, dict.size());
+            size_t entry = payload + 8;
+            for (const auto& [key, item] : dict) {
+                Write<uint64_t>(entry, AddKey(key.View()));
+                WriteSlot(entry + 8, item);
+                entry += kEntrySize;
+            }
+            break;
+        }
+        }
+        Write<uint32_t>(slot, tag);
+        Write<uint64_t>(slot + kPayloadOffset, payload);
+    }
+
+    string image_;
+    // Ключи ссылаются на сохраняемый документ, который живёт дольше построения
+    unordered_map<string_view, size_t> keys_;
+};
+
+}  // namespace
+
+SnapshotNode::SnapshotNode(string_view image, size_t slot)
+    : image_(image)
+    , tag_(Read<uint32_t>(image, slot))
+    , payload_(Read<uint64_t>(image, slot + kPayloadOffset)) {
+    if (tag_ > kDict) {
+        ThrowCorrupted();
+    }
+}
+
+bool SnapshotNode::IsNull() const {
+    return tag_ == kNull;
+}
+
+bool SnapshotNode::IsBool() const {
+    return tag_ == kBool;
+}
+
+bool SnapshotNode::IsInt() const {
+    return tag_ == kInt;
+}
+
+bool SnapshotNode::IsInt64() const {
+    return tag_ == kInt || tag_ == kInt64 || (tag_ == kUint64 && payload_ <= static_cast<uint64_t>(INT64_MAX));
+}
+
+bool SnapshotNode::IsUint64() const {
+    return ((tag_ == kInt || tag_ == kInt64) && static_cast<int64_t>(payload_) >= 0) || tag_ == kUint64;
+}
+
+bool SnapshotNode::IsDouble() const {
+    return tag_ == kInt || tag_ == kInt64 || tag_ == kUint64 || tag_ == kDouble;
+}
+
+bool SnapshotNode::IsPureDouble() const {
+    return tag_ == kDouble;
+}
+
+bool SnapshotNode::IsString() const {
+    return tag_ == kString;
+}
+
+bool SnapshotNode::IsArray() const {
+    return tag_ == kArray;
+}
+
+bool SnapshotNode::IsMap() const {
+    return tag_ == kDict;
+}
+
+bool SnapshotNode::AsBool() const {
+    if (!IsBool()) throw logic_error("Not a bool");
+    return payload_ != 0;
+}
+
+int SnapshotNode::AsInt() const {
+    if (!IsInt()) throw logic_error("Not an int");
+    return static_cast<int>(static_cast<int64_t>(payload_));
+}
+
+int64_t SnapshotNode::AsInt64() const {
+    if (!IsInt64()) throw logic_error("Not an int64");
+    return static_cast<int64_t>(payload_);
+}
+
+uint64_t SnapshotNode::AsUint64() const {
+    if (!IsUint64()) throw logic_error("Not an uint64");
+    return payload_;
+}
+
+double SnapshotNode::AsDouble() const {
+    if (!IsDouble()) throw logic_error("Not a double");
+    switch (tag_) {
+    case kDouble:
+        return bit_cast<double>(payload_);
+    case kUint64:
+        return static_cast<double>(payload_);
+    default:
+        return static_cast<double>(static_cast<int64_t>(payload_));
+    }
+}
+
+string_view SnapshotNode::AsString() const {
+    if (!IsString()) throw logic_error("Not a string");
+    return ReadString(image_, static_cast<size_t>(payload_));
+}
+
+SnapshotArray SnapshotNode::AsArray() const {
+    if (!IsArray()) throw logic_error("Not an array");
+    return SnapshotArray(image_, static_cast<size_t>(payload_));
+}
+
+SnapshotDict SnapshotNode::AsMap() const {
+    if (!IsMap()) throw logic_error("Not a map");
+    return SnapshotDict(image_, static_cast<size_t>(payload_));
+}
+
+Node SnapshotNode::ToNode() const {
+    detail::KeyTable keys;
+    return ToNode(keys);
+}
+
+Node SnapshotNode::ToNode(detail::KeyTable& keys) const {
+    switch (tag_) {
+    case kNull:
+        return nullptr;
+    case kBool:
+        return AsBool();
+    case kInt:
+        return AsInt();
+    case kInt64:
+        return static_cast<int64_t>(payload_);
+    case kUint64:
+        return payload_;
+    case kDouble:
+        return AsDouble();
+    case kString:
+        return std::string(AsString());
+    case kArray: {
+        const SnapshotArray array = AsArray();
+        Array result;
+        result.reserve(array.size());
+        for (const SnapshotNode item : array) {
+            result.push_back(item.ToNode(keys));
+        }
+        return result;
+    }
+    default: {
+        const SnapshotDict dict = AsMap();
+        Dict result;
+        result.reserve(dict.size());
+        for (const auto& [key, item] : dict) {
+            result.try_emplace(keys.Intern(key), item.ToNode(keys));
+        }
+        return result;
+    }
+    }
+}
+
+SnapshotArray::SnapshotArray(string_view image, size_t block)
+    : image_(image)
+    , items_(block + 8)
+    , size_(static_cast<size_t>(Read<uint64_t>(image, block))) {
+    CheckRange(image, items_, size_, kSlotSize);
+}
+
+SnapshotNode SnapshotArray::Iterator::operator*() const {
+    return Get(image_, items_, index_);
+}
+
+SnapshotNode SnapshotArray::at(size_t index) const {
+    if (index >= size_) {
+        throw out_of_range("Array index out of range");
+    }
+    return Get(image_, items_, index);
+}
+
+SnapshotNode SnapshotArray::Get(string_view image, size_t items, size_t index) {
+    return SnapshotNode(image, items + index * kSlotSize);
+}
+
+SnapshotDict::SnapshotDict(string_view image, size_t block)
+    : image_(image)
+    , entries_(block + 8)
+    , size_(static_cast<size_t>(Read<uint64_t>(image, block))) {
+    CheckRange(image, entries_, size_, kEntrySize);
+}
+
+SnapshotDict::Iterator SnapshotDict::find(string_view key) const {
+    size_t low = 0;
+    size_t high = size_;
+    while (low < high) {
+        const size_t middle = low + (high - low) / 2;
+        const string_view candidate = GetKey(image_, entries_, middle);
+        if (candidate == key) {
+            return Iterator(image_, entries_, middle);
+        }
+        if (candidate < key) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return end();
+}
+
+SnapshotNode SnapshotDict::at(string_view key) const {
+    const Iterator it = find(key);
+    if (it == end()) {
+        throw out_of_range("Key not found: "s + string(key));
+    }
+    return GetValue(image_, entries_, it.index_);
+}
+
+SnapshotDict::Iterator::value_type SnapshotDict::Iterator::operator*() const {
+    return {GetKey(image_, entries_, index_), GetValue(image_, entries_, index_)};
+}
+
+string_view SnapshotDict::GetKey(string_view image, size_t entries, size_t index) {
+    return ReadString(image, static_cast<size_t>(Read<uint64_t>(image, entries + index * kEntrySize)));
+}
+
+SnapshotNode SnapshotDict::GetValue(string_view image, size_t entries, size_t index) {
+    return SnapshotNode(image, entries + index * kEntrySize + 8);
+}
+
+void Snapshot::Save(const Document& doc, ostream& output) {
+    const string image = ImageBuilder{}.Build(doc.GetRoot());
+    output.write(image.data(), static_cast<streamsize>(image.size()));
+}
+
+void Snapshot::Save(const Document& doc, const filesystem::path& path) {
+    ofstream output(path, ios::binary | ios::trunc);
+    if (!output) {
+        throw system_error(errno, generic_category(), "Cannot create snapshot file");
+    }
+    Save(doc, output);
+    output.close();
+    if (!output) {
+        throw system_error(errno, generic_category(), "Cannot write snapshot file");
+    }
+}
+
+Snapshot Snapshot::Open(const filesystem::path& path) {
+    auto file = make_shared<const MappedFile>(path, MappedFile::Access::Random);
+    const string_view image = file->GetText();
+    return Snapshot(image, move(file));
+}
+
+Snapshot::Snapshot(string_view image)
+    : Snapshot(image, nullptr) {
+}
+
+Snapshot::Snapshot(string_view image, shared_ptr<const void> owner)
+    : owner_(move(owner))
+    , image_(image) {
+    if (image.size() < kHeaderSize || image.substr(0, kMagic.size()) != kMagic) {
+        throw ParsingError("Not a JSON snapshot");
+    }
+    if (Read<uint32_t>(image, kVersionOffset) != kVersion) {
+        throw ParsingError("Unsupported JSON snapshot version");
+    }
+    if (Read<uint64_t>(image, kSizeOffset) != image.size()) {
+        throw ParsingError("JSON snapshot is truncated");
+    }
+}
+
+SnapshotNode Snapshot::GetRoot() const {
+    return SnapshotNode(image_, kRootOffset);
+}
+
+}  // namespace json
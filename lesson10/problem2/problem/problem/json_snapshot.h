@@ -0,0 +1,223 @@
+#pragma once
+
+#include "json.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <iosfwd>
+#include <iterator>
+#include <memory>
+#include <string_view>
+#include <utility>
+
+namespace json {
+
+class SnapshotArray;
+class SnapshotDict;
+
+// Значение снимка. Читается прямо из образа, ничего не выделяя.
+// Действительно, пока жив снимок, из которого получено.
+class SnapshotNode {
+public:
+    bool IsNull() const;
+    bool IsBool() const;
+    bool IsInt() const;
+    bool IsInt64() const;
+    bool IsUint64() const;
+    bool IsDouble() const;
+    bool IsPureDouble() const;
+    bool IsString() const;
+    bool IsArray() const;
+    bool IsMap() const;
+
+    bool AsBool() const;
+    int AsInt() const;
+    int64_t AsInt64() const;
+    uint64_t AsUint64() const;
+    double AsDouble() const;
+    std::string_view AsString() const;
+    SnapshotArray AsArray() const;
+    SnapshotDict AsMap() const;
+
+    // Копирует поддерево в обычный Node
+    Node ToNode() const;
+
+private:
+    friend class Snapshot;
+    friend class SnapshotArray;
+    friend class SnapshotDict;
+
+    // Читает значение из ячейки образа по смещению slot
+    SnapshotNode(std::string_view image, size_t slot);
+
+    Node ToNode(detail::KeyTable& keys) const;
+
+    std::string_view image_;
+    uint32_t tag_;
+    uint64_t payload_;
+};
+
+// Массив снимка: ячейки элементов идут в образе подряд
+class SnapshotArray {
+public:
+    class Iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = SnapshotNode;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+        using reference = SnapshotNode;
+
+        Iterator() = default;
+
+        SnapshotNode operator*() const;
+        Iterator& operator++() {
+            ++index_;
+            return *this;
+        }
+        Iterator operator++(int) {
+            Iterator prev = *this;
+            ++index_;
+            return prev;
+        }
+        bool operator==(const Iterator& other) const { return index_ == other.index_; }
+        bool operator!=(const Iterator& other) const { return !(*this == other); }
+
+    private:
+        friend class SnapshotArray;
+        Iterator(std::string_view image, size_t items, size_t index)
+            : image_(image)
+            , items_(items)
+            , index_(index) {
+        }
+
+        // Итератор не ссылается на SnapshotArray и переживает его
+        std::string_view image_;
+        size_t items_ = 0;
+        size_t index_ = 0;
+    };
+
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    SnapshotNode operator[](size_t index) const { return Get(image_, items_, index); }
+    // Выбрасывает std::out_of_range, если элемента нет
+    SnapshotNode at(size_t index) const;
+
+    Iterator begin() const { return Iterator(image_, items_, 0); }
+    Iterator end() const { return Iterator(image_, items_, size_); }
+
+private:
+    friend class SnapshotNode;
+    SnapshotArray(std::string_view image, size_t block);
+
+    // Ячейки элементов начинаются со смещения items
+    static SnapshotNode Get(std::string_view image, size_t items, size_t index);
+
+    std::string_view image_;
+    size_t items_;
+    size_t size_;
+};
+
+// Словарь снимка: записи отсортированы по ключу, как в Dict, поэтому
+// поиск — двоичный по таблице ключей объекта
+class SnapshotDict {
+public:
+    class Iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = std::pair<std::string_view, SnapshotNode>;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+        using reference = value_type;
+
+        Iterator() = default;
+
+        value_type operator*() const;
+        Iterator& operator++() {
+            ++index_;
+            return *this;
+        }
+        Iterator operator++(int) {
+            Iterator prev = *this;
+            ++index_;
+            return prev;
+        }
+        bool operator==(const Iterator& other) const { return index_ == other.index_; }
+        bool operator!=(const Iterator& other) const { return !(*this == other); }
+
+    private:
+        friend class SnapshotDict;
+        Iterator(std::string_view image, size_t entries, size_t index)
+            : image_(image)
+            , entries_(entries)
+            , index_(index) {
+        }
+
+        std::string_view image_;
+        size_t entries_ = 0;
+        size_t index_ = 0;
+    };
+
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    size_t count(std::string_view key) const { return find(key) != end() ? 1 : 0; }
+    Iterator find(std::string_view key) const;
+    // Выбрасывает std::out_of_range, если ключа нет
+    SnapshotNode at(std::string_view key) const;
+
+    Iterator begin() const { return Iterator(image_, entries_, 0); }
+    Iterator end() const { return Iterator(image_, entries_, size_); }
+
+private:
+    friend class SnapshotNode;
+    SnapshotDict(std::string_view image, size_t block);
+
+    // Записи начинаются со смещения entries
+    static std::string_view GetKey(std::string_view image, size_t entries, size_t index);
+    static SnapshotNode GetValue(std::string_view image, size_t entries, size_t index);
+
+    std::string_view image_;
+    size_t entries_;
+    size_t size_;
+};
+
+// Заранее разобранный документ в виде образа, который читается на месте:
+// открытие снимка сводится к отображению файла в память, без разбора
+// и без выделения памяти под дерево. Все ссылки внутри образа — смещения
+// от его начала, поэтому образ можно отображать по любому адресу.
+//
+// Образ: заголовок "JSNS", версия, размер образа и ячейка корня. Ячейка
+// значения — 16 байт: тег и 8 байт данных (число, биты double или
+// смещение). Строка — длина и байты; массив — число элементов и их
+// ячейки подряд; словарь — число записей и записи из смещения ключа
+// и ячейки значения, отсортированные по ключу. Одинаковые ключи
+// хранятся один раз. Числа записаны в порядке байтов little-endian.
+//
+// Образ при открытии не проверяется целиком: границы проверяются при
+// обращении, и повреждённые данные дают ParsingError, а не выход за буфер.
+class Snapshot {
+public:
+    // Образ строится в памяти целиком и затем записывается.
+    // Ошибка записи файла — std::system_error.
+    static void Save(const Document& doc, std::ostream& output);
+    static void Save(const Document& doc, const std::filesystem::path& path);
+
+    // Отображает файл в память. Значения, полученные из снимка,
+    // действительны, пока он жив.
+    static Snapshot Open(const std::filesystem::path& path);
+
+    // Образ не копируется: image должен жить, пока жив снимок
+    explicit Snapshot(std::string_view image);
+
+    SnapshotNode GetRoot() const;
+    size_t GetSize() const { return image_.size(); }
+
+private:
+    Snapshot(std::string_view image, std::shared_ptr<const void> owner);
+
+    std::shared_ptr<const void> owner_;
+    std::string_view image_;
+};
+
+}  // namespace json
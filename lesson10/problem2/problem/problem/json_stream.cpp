@@ -0,0 +1,73 @@
+#include "json_stream.h"
+#include "json_parser.h"
+
+using namespace std;
+
+namespace json {
+
+struct ArrayReader::Impl {
+    explicit Impl(istream& input)
+        : parser(input, builder) {
+    }
+
+    detail::DomBuilder builder;
+    detail::Parser<detail::DomBuilder> parser;
+    bool first = true;
+    bool finished = false;
+};
+
+ArrayReader::ArrayReader(istream& input)
+    : impl_(make_unique<Impl>(input)) {
+    if (impl_->parser.NextToken("Expected '[' at the start of input") != '[') {
+        throw ParsingError("Expected '[' at the start of input");
+    }
+}
+
+ArrayReader::~ArrayReader() = default;
+
+optional<Node> ArrayReader::Next() {
+    if (!Advance()) {
+        return nullopt;
+    }
+    optional<Node> result = move(current_);
+    current_.reset();
+    return result;
+}
+
+ArrayReader::Iterator ArrayReader::begin() {
+    if (!current_ && !Advance()) {
+        return end();
+    }
+    return Iterator(this);
+}
+
+bool ArrayReader::Advance() {
+    Impl& impl = *impl_;
+    current_.reset();
+    if (impl.finished) {
+        return false;
+    }
+
+    if (impl.first) {
+        impl.first = false;
+        if (impl.parser.PeekToken() == ']') {
+            impl.parser.NextToken("Expected ']'");
+            impl.finished = true;
+            return false;
+        }
+    } else {
+        const char c = impl.parser.NextToken("Expected ',' or ']' in array");
+        if (c == ']') {
+            impl.finished = true;
+            return false;
+        } else if (c != ',') {
+            throw ParsingError("Expected ',' or ']' in array");
+        }
+    }
+
+    impl.parser.ParseValue();
+    current_ = impl.builder.ExtractRoot();
+    return true;
+}
+
+}  // namespace json
@@ -0,0 +1,79 @@
+#pragma once
+
+#include "json.h"
+
+#include <cstddef>
+#include <iosfwd>
+#include <iterator>
+#include <memory>
+#include <optional>
+
+namespace json {
+
+// Поэлементное чтение массива верхнего уровня из потока. В памяти держится
+// только текущий элемент и блок входа, поэтому расход памяти не зависит
+// от числа элементов, а первый элемент доступен сразу после его разбора.
+//
+//     ArrayReader reader(input);
+//     for (const Node& record : reader) { ... }
+//
+// Поток должен жить, пока используется ArrayReader.
+class ArrayReader {
+public:
+    class Iterator {
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = Node;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const Node*;
+        using reference = const Node&;
+
+        Iterator() = default;
+
+        const Node& operator*() const { return *reader_->current_; }
+        const Node* operator->() const { return &*reader_->current_; }
+
+        Iterator& operator++() {
+            if (!reader_->Advance()) {
+                reader_ = nullptr;
+            }
+            return *this;
+        }
+        void operator++(int) { ++*this; }
+
+        bool operator==(const Iterator& other) const { return reader_ == other.reader_; }
+        bool operator!=(const Iterator& other) const { return reader_ != other.reader_; }
+
+    private:
+        friend class ArrayReader;
+        explicit Iterator(ArrayReader* reader)
+            : reader_(reader) {
+        }
+
+        ArrayReader* reader_ = nullptr;
+    };
+
+    // Читает открывающую скобку массива; ParsingError, если вход начинается не с '['
+    explicit ArrayReader(std::istream& input);
+    ~ArrayReader();
+
+    ArrayReader(const ArrayReader&) = delete;
+    ArrayReader& operator=(const ArrayReader&) = delete;
+
+    // Следующий элемент массива либо nullopt, если массив закончился
+    std::optional<Node> Next();
+
+    // Итерирование продолжает чтение с текущей позиции
+    Iterator begin();
+    Iterator end() { return Iterator(); }
+
+private:
+    struct Impl;
+
+    bool Advance();
+
+    std::unique_ptr<Impl> impl_;
+    std::optional<Node> current_;
+};
+
+}  // namespace json
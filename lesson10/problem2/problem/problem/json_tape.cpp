@@ -0,0 +1,363 @@
+#include "json_tape.h"
+#include "json_parser.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+using namespace std;
+
+namespace json {
+
+bool NodeRef::AsBool() const {
+    if (!IsBool()) throw logic_error("Not a bool");
+    return Payload() != 0;
+}
+
+int NodeRef::AsInt() const {
+    if (!IsInt()) throw logic_error("Not an int");
+    return static_cast<int>(static_cast<uint32_t>(Payload()));
+}
+
+bool NodeRef::IsInt64() const {
+    switch (Tag()) {
+    case Type::Int:
+    case Type::Int64: return true;
+    case Type::Uint64: return OutOfLine() <= static_cast<uint64_t>(INT64_MAX);
+    default: return false;
+    }
+}
+
+bool NodeRef::IsUint64() const {
+    switch (Tag()) {
+    case Type::Int: return AsInt() >= 0;
+    case Type::Int64: return static_cast<int64_t>(OutOfLine()) >= 0;
+    case Type::Uint64: return true;
+    default: return false;
+    }
+}
+
+int64_t NodeRef::AsInt64() const {
+    if (!IsInt64()) throw logic_error("Not an int64");
+    if (IsInt()) {
+        return AsInt();
+    }
+    return static_cast<int64_t>(OutOfLine());
+}
+
+uint64_t NodeRef::AsUint64() const {
+    if (!IsUint64()) throw logic_error("Not an uint64");
+    if (IsInt()) {
+        return static_cast<uint64_t>(AsInt());
+    }
+    return OutOfLine();
+}
+
+double NodeRef::AsDouble() const {
+    if (IsInt()) {
+        return static_cast<double>(AsInt());
+    }
+    if (Tag() == Type::Int64) {
+        return static_cast<double>(static_cast<int64_t>(OutOfLine()));
+    }
+    if (Tag() == Type::Uint64) {
+        return static_cast<double>(OutOfLine());
+    }
+    if (!IsPureDouble()) throw logic_error("Not a double");
+    double value;
+    const uint64_t bits = OutOfLine();
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+string_view NodeRef::AsString() const {
+    if (!IsString()) throw logic_error("Not a string");
+    return doc_->StringAt(Payload());
+}
+
+ArrayRef NodeRef::AsArray() const {
+    if (!IsArray()) throw logic_error("Not an array");
+    return ArrayRef(doc_, Payload());
+}
+
+DictRef NodeRef::AsMap() const {
+    if (!IsMap()) throw logic_error("Not a map");
+    return DictRef(doc_, Payload());
+}
+
+Node NodeRef::ToNode() const {
+    detail::KeyTable keys;
+    return ToNode(keys);
+}
+
+Node NodeRef::ToNode(detail::KeyTable& keys) const {
+    switch (Tag()) {
+    case Type::Null: return Node(nullptr);
+    case Type::Bool: return Node(AsBool());
+    case Type::Int: return Node(AsInt());
+    case Type::Double: return Node(AsDouble());
+    case Type::Int64: return Node(AsInt64());
+    case Type::Uint64: return Node(AsUint64());
+    case Type::String: return Node(string(AsString()));
+    case Type::Array: {
+        const ArrayRef arr = AsArray();
+        Array result;
+        result.reserve(arr.size());
+        for (const NodeRef item : arr) {
+            result.push_back(item.ToNode(keys));
+        }
+        return Node(move(result));
+    }
+    case Type::Map: {
+        Dict result;
+        for (const auto& [key, value] : AsMap()) {
+            result.emplace_hint(result.end(), keys.Intern(key), value.ToNode(keys));
+        }
+        return Node(move(result));
+    }
+    }
+    throw logic_error("Corrupted tape");
+}
+
+uint64_t NodeRef::OutOfLine() const {
+    return doc_->tape_[Payload()];
+}
+
+size_t ArrayRef::size() const {
+    return static_cast<size_t>(doc_->tape_[body_]);
+}
+
+NodeRef ArrayRef::operator[](size_t index) const {
+    return NodeRef(doc_, doc_->tape_[body_ + 1 + index]);
+}
+
+NodeRef ArrayRef::at(size_t index) const {
+    if (index >= size()) {
+        throw out_of_range("Array index out of range");
+    }
+    return (*this)[index];
+}
+
+ArrayRef::Iterator ArrayRef::begin() const {
+    return Iterator(doc_, doc_->tape_.data() + body_ + 1);
+}
+
+ArrayRef::Iterator ArrayRef::end() const {
+    return Iterator(doc_, doc_->tape_.data() + body_ + 1 + size());
+}
+
+size_t DictRef::size() const {
+    return static_cast<size_t>(doc_->tape_[body_]);
+}
+
+DictRef::Iterator DictRef::find(string_view key) const {
+    // Ключи упорядочены, поэтому ищем двоичным поиском по парам слов
+    const uint64_t* first = doc_->tape_.data() + body_ + 1;
+    size_t count = size();
+    while (count > 0) {
+        const size_t half = count / 2;
+        const uint64_t* middle = first + 2 * half;
+        if (NodeRef(doc_, *middle).AsString() < key) {
+            first = middle + 2;
+            count -= half + 1;
+        } else {
+            count = half;
+        }
+    }
+    if (first != end().word_ && NodeRef(doc_, *first).AsString() == key) {
+        return Iterator(doc_, first);
+    }
+    return end();
+}
+
+NodeRef DictRef::at(string_view key) const {
+    const Iterator it = find(key);
+    if (it == end()) {
+        throw out_of_range("Key not found: "s + string(key));
+    }
+    return (*it).second;
+}
+
+DictRef::Iterator DictRef::begin() const {
+    return Iterator(doc_, doc_->tape_.data() + body_ + 1);
+}
+
+DictRef::Iterator DictRef::end() const {
+    return Iterator(doc_, doc_->tape_.data() + body_ + 1 + 2 * size());
+}
+
+// Обработчик событий разбора, дописывающий значения в ленту. Элементы
+// незавершённых контейнеров копятся в pending_ и переносятся в ленту
+// одним телом, когда контейнер закрывается.
+class TapeBuilder {
+public:
+    explicit TapeBuilder(TapeDocument& doc)
+        : doc_(doc) {
+        // Нулевое слово ленты — корень документа
+        doc_.tape_.push_back(0);
+    }
+
+    void Null() { Add(Word(Type::Null, 0)); }
+    void Bool(bool value) { Add(Word(Type::Bool, value ? 1 : 0)); }
+    void Int(int value) { Add(Word(Type::Int, static_cast<uint32_t>(value))); }
+
+    void Int64(int64_t value) { AddOutOfLine(Type::Int64, static_cast<uint64_t>(value)); }
+    void Uint64(uint64_t value) { AddOutOfLine(Type::Uint64, value); }
+
+    void Double(double value) {
+        uint64_t bits;
+        memcpy(&bits, &value, sizeof(bits));
+        AddOutOfLine(Type::Double, bits);
+    }
+
+    void String(string_view value) { Add(Word(Type::String, doc_.AppendString(value))); }
+
+    void StartArray() { frames_.push_back(pending_.size()); }
+    void StartObject() { frames_.push_back(pending_.size()); }
+    void Key(string_view key) { pending_.push_back(Word(Type::String, doc_.AppendString(key))); }
+
+    void EndArray() { Add(Word(Type::Array, FlushBody(1))); }
+
+    void EndObject() {
+        SortKeys();
+        Add(Word(Type::Map, FlushBody(2)));
+    }
+
+    void Finish() {
+        doc_.tape_.shrink_to_fit();
+        doc_.strings_.shrink_to_fit();
+    }
+
+private:
+    using Type = NodeRef::Type;
+
+    static uint64_t Word(Type type, uint64_t payload) {
+        return (uint64_t{static_cast<uint8_t>(type)} << 56) | payload;
+    }
+
+    void Add(uint64_t word) {
+        if (frames_.empty()) {
+            doc_.tape_[0] = word;
+        } else {
+            pending_.push_back(word);
+        }
+    }
+
+    // Значение целиком занимает отдельное слово ленты, а узел ссылается на него
+    void AddOutOfLine(Type type, uint64_t bits) {
+        doc_.tape_.push_back(bits);
+        Add(Word(type, doc_.tape_.size() - 1));
+    }
+
+    // Переносит элементы текущего контейнера в ленту: счётчик и слова подряд
+    size_t FlushBody(size_t words_per_item) {
+        const size_t start = frames_.back();
+        frames_.pop_back();
+        vector<uint64_t>& tape = doc_.tape_;
+        const size_t body = tape.size();
+        tape.push_back((pending_.size() - start) / words_per_item);
+        tape.insert(tape.end(), pending_.begin() + static_cast<ptrdiff_t>(start), pending_.end());
+        pending_.resize(start);
+        return body;
+    }
+
+    // Упорядочивает пары по ключу, как в Dict; из повторяющихся ключей
+    // остаётся последний
+    void SortKeys() {
+        const size_t start = frames_.back();
+        const size_t count = (pending_.size() - start) / 2;
+        auto key = [this](uint64_t word) {
+            return doc_.StringAt(word & ((uint64_t{1} << 56) - 1));
+        };
+
+        bool sorted = true;
+        for (size_t i = 1; i < count && sorted; ++i) {
+            sorted = key(pending_[start + 2 * (i - 1)]) < key(pending_[start + 2 * i]);
+        }
+        if (sorted) {
+            return;
+        }
+
+        pairs_.clear();
+        for (size_t i = 0; i < count; ++i) {
+            pairs_.emplace_back(pending_[start + 2 * i], pending_[start + 2 * i + 1]);
+        }
+        stable_sort(pairs_.begin(), pairs_.end(), [&key](const auto& lhs, const auto& rhs) {
+            return key(lhs.first) < key(rhs.first);
+        });
+        pending_.resize(start);
+        for (size_t i = 0; i < pairs_.size(); ++i) {
+            if (i + 1 < pairs_.size() && key(pairs_[i].first) == key(pairs_[i + 1].first)) {
+                continue;
+            }
+            pending_.push_back(pairs_[i].first);
+            pending_.push_back(pairs_[i].second);
+        }
+    }
+
+    TapeDocument& doc_;
+    vector<uint64_t> pending_;
+    // Начала незавершённых контейнеров в pending_
+    vector<size_t> frames_;
+    vector<pair<uint64_t, uint64_t>> pairs_;
+};
+
+TapeDocument::TapeDocument(const Node& root) {
+    TapeBuilder builder(*this);
+    detail::EmitEvents(root, builder);
+    builder.Finish();
+}
+
+TapeDocument::TapeDocument(const Document& doc)
+    : TapeDocument(doc.GetRoot()) {
+}
+
+TapeDocument::TapeDocument(string_view input) {
+    TapeBuilder builder(*this);
+    detail::Parser parser(input, builder);
+    parser.ParseValue();
+    builder.Finish();
+}
+
+TapeDocument::TapeDocument(istream& input) {
+    TapeBuilder builder(*this);
+    detail::Parser parser(input, builder);
+    parser.ParseValue();
+    builder.Finish();
+}
+
+Document TapeDocument::ToDocument() const {
+    return Document{GetRoot().ToNode()};
+}
+
+size_t TapeDocument::GetMemoryUsage() const {
+    return tape_.capacity() * sizeof(uint64_t) + strings_.capacity();
+}
+
+uint64_t TapeDocument::AppendString(string_view str) {
+    // Строка хранится как 32-битная длина и следом байты без завершающего нуля
+    if (str.size() > UINT32_MAX) {
+        throw length_error("String is too long for a tape document");
+    }
+    const uint64_t offset = strings_.size();
+    const uint32_t length = static_cast<uint32_t>(str.size());
+    strings_.append(reinterpret_cast<const char*>(&length), sizeof(length));
+    strings_.append(str);
+    return offset;
+}
+
+string_view TapeDocument::StringAt(uint64_t offset) const {
+    uint32_t length;
+    memcpy(&length, strings_.data() + offset, sizeof(length));
+    return string_view(strings_.data() + offset + sizeof(length), length);
+}
+
+TapeDocument LoadTape(istream& input) {
+    return TapeDocument(input);
+}
+
+TapeDocument LoadTape(string_view input) {
+    return TapeDocument(input);
+}
+
+}  // namespace json
@@ -0,0 +1,224 @@
+#pragma once
+
+#include "json.h"
+
+#include <cstdint>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace json {
+
+class TapeDocument;
+class ArrayRef;
+class DictRef;
+
+// Лёгкое представление узла TapeDocument. Действительно, пока жив документ.
+class NodeRef {
+public:
+    bool IsNull() const { return Tag() == Type::Null; }
+    bool IsBool() const { return Tag() == Type::Bool; }
+    bool IsInt() const { return Tag() == Type::Int; }
+    bool IsInt64() const;
+    bool IsUint64() const;
+    bool IsDouble() const { return IsInt() || Tag() == Type::Int64 || Tag() == Type::Uint64 || IsPureDouble(); }
+    bool IsPureDouble() const { return Tag() == Type::Double; }
+    bool IsString() const { return Tag() == Type::String; }
+    bool IsArray() const { return Tag() == Type::Array; }
+    bool IsMap() const { return Tag() == Type::Map; }
+
+    bool AsBool() const;
+    int AsInt() const;
+    int64_t AsInt64() const;
+    uint64_t AsUint64() const;
+    double AsDouble() const;
+    std::string_view AsString() const;
+    ArrayRef AsArray() const;
+    DictRef AsMap() const;
+
+    // Глубокая копия поддерева в виде обычного Node
+    Node ToNode() const;
+
+private:
+    friend class TapeDocument;
+    friend class TapeBuilder;
+    friend class ArrayRef;
+    friend class DictRef;
+
+    // Одинаковые длинные ключи поддерева получают общий Symbol из keys
+    Node ToNode(detail::KeyTable& keys) const;
+
+    // Слово ленты: старшие 8 бит — тип, младшие 56 бит — значение
+    // либо смещение (в ленте или в буфере строк). Double, Int64 и Uint64
+    // не умещаются в 56 бит и хранятся отдельным словом ленты.
+    enum class Type : uint8_t { Null, Bool, Int, Double, String, Array, Map, Int64, Uint64 };
+
+    NodeRef(const TapeDocument* doc, uint64_t word)
+        : doc_(doc)
+        , word_(word) {
+    }
+
+    Type Tag() const { return static_cast<Type>(word_ >> 56); }
+    uint64_t Payload() const { return word_ & ((uint64_t{1} << 56) - 1); }
+    uint64_t OutOfLine() const;
+
+    const TapeDocument* doc_;
+    uint64_t word_;
+};
+
+// Массив на ленте: счётчик и следом по одному слову на элемент,
+// поэтому доступ по индексу выполняется за O(1)
+class ArrayRef {
+public:
+    class Iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = NodeRef;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+        using reference = NodeRef;
+
+        Iterator() = default;
+
+        NodeRef operator*() const { return NodeRef(doc_, *word_); }
+        Iterator& operator++() {
+            ++word_;
+            return *this;
+        }
+        Iterator operator++(int) {
+            Iterator prev = *this;
+            ++word_;
+            return prev;
+        }
+        bool operator==(const Iterator& other) const { return word_ == other.word_; }
+        bool operator!=(const Iterator& other) const { return word_ != other.word_; }
+
+    private:
+        friend class ArrayRef;
+        Iterator(const TapeDocument* doc, const uint64_t* word)
+            : doc_(doc)
+            , word_(word) {
+        }
+
+        const TapeDocument* doc_ = nullptr;
+        const uint64_t* word_ = nullptr;
+    };
+
+    size_t size() const;
+    bool empty() const { return size() == 0; }
+    NodeRef operator[](size_t index) const;
+    NodeRef at(size_t index) const;
+
+    Iterator begin() const;
+    Iterator end() const;
+
+private:
+    friend class NodeRef;
+    ArrayRef(const TapeDocument* doc, size_t body)
+        : doc_(doc)
+        , body_(body) {
+    }
+
+    const TapeDocument* doc_;
+    size_t body_;
+};
+
+// Словарь на ленте: счётчик и пары слов (ключ, значение),
+// упорядоченные по ключу так же, как в Dict
+class DictRef {
+public:
+    class Iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = std::pair<std::string_view, NodeRef>;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+        using reference = value_type;
+
+        Iterator() = default;
+
+        value_type operator*() const {
+            return {NodeRef(doc_, word_[0]).AsString(), NodeRef(doc_, word_[1])};
+        }
+        Iterator& operator++() {
+            word_ += 2;
+            return *this;
+        }
+        Iterator operator++(int) {
+            Iterator prev = *this;
+            word_ += 2;
+            return prev;
+        }
+        bool operator==(const Iterator& other) const { return word_ == other.word_; }
+        bool operator!=(const Iterator& other) const { return word_ != other.word_; }
+
+    private:
+        friend class DictRef;
+        Iterator(const TapeDocument* doc, const uint64_t* word)
+            : doc_(doc)
+            , word_(word) {
+        }
+
+        const TapeDocument* doc_ = nullptr;
+        const uint64_t* word_ = nullptr;
+    };
+
+    size_t size() const;
+    bool empty() const { return size() == 0; }
+    size_t count(std::string_view key) const { return find(key) != end() ? 1 : 0; }
+    Iterator find(std::string_view key) const;
+    // Выбрасывает std::out_of_range, если ключа нет
+    NodeRef at(std::string_view key) const;
+
+    Iterator begin() const;
+    Iterator end() const;
+
+private:
+    friend class NodeRef;
+    DictRef(const TapeDocument* doc, size_t body)
+        : doc_(doc)
+        , body_(body) {
+    }
+
+    const TapeDocument* doc_;
+    size_t body_;
+};
+
+// Неизменяемый документ, уложенный в одну ленту 64-битных слов и буфер строк.
+// Занимает в несколько раз меньше памяти, чем дерево Node, и читается
+// последовательно, но не допускает модификации.
+class TapeDocument {
+public:
+    explicit TapeDocument(const Node& root);
+    explicit TapeDocument(const Document& doc);
+    // Разбирает текст сразу в ленту, минуя дерево Node
+    explicit TapeDocument(std::string_view input);
+    explicit TapeDocument(std::istream& input);
+
+    NodeRef GetRoot() const { return NodeRef(this, tape_.front()); }
+    Document ToDocument() const;
+
+    // Объём ленты и буфера строк в байтах
+    size_t GetMemoryUsage() const;
+
+private:
+    friend class NodeRef;
+    friend class ArrayRef;
+    friend class DictRef;
+    friend class TapeBuilder;
+
+    TapeDocument() = default;
+
+    uint64_t AppendString(std::string_view str);
+    std::string_view StringAt(uint64_t offset) const;
+
+    std::vector<uint64_t> tape_;
+    std::string strings_;
+};
+
+TapeDocument LoadTape(std::istream& input);
+TapeDocument LoadTape(std::string_view input);
+
+}  // namespace json
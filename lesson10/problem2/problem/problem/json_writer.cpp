@@ -0,0 +1,178 @@
+#include "json_writer.h"
+#include "json_parser.h"
+#include "json_scan.h"
+
+#include <charconv>
+#include <ostream>
+
+using namespace std;
+
+namespace json {
+
+Writer::Writer(ostream& output, const WriterOptions& options)
+    : output_(output)
+    , compact_(options.compact)
+    , indent_(options.compact ? 0 : static_cast<size_t>(max(options.indent, 0)))
+    , buffer_size_(max<size_t>(options.buffer_size, 64)) {
+    buffer_.reserve(buffer_size_);
+}
+
+Writer::~Writer() {
+    Flush();
+}
+
+void Writer::Write(const Node& node) {
+    detail::EmitEvents(node, *this);
+}
+
+void Writer::Null() {
+    BeforeValue();
+    Append("null"sv);
+}
+
+void Writer::Bool(bool value) {
+    BeforeValue();
+    Append(value ? "true"sv : "false"sv);
+}
+
+void Writer::Int(int value) {
+    BeforeValue();
+    WriteNumber(value);
+}
+
+void Writer::Int64(int64_t value) {
+    BeforeValue();
+    WriteNumber(value);
+}
+
+void Writer::Uint64(uint64_t value) {
+    BeforeValue();
+    WriteNumber(value);
+}
+
+void Writer::Double(double value) {
+    BeforeValue();
+    // Тот же формат, что у operator<< с настройками потока по умолчанию
+    char digits[32];
+    const auto result = to_chars(begin(digits), end(digits), value, chars_format::general, 6);
+    Append(string_view(digits, static_cast<size_t>(result.ptr - digits)));
+}
+
+void Writer::String(string_view value) {
+    BeforeValue();
+    WriteEscaped(value);
+}
+
+void Writer::StartArray() {
+    BeforeValue();
+    Put('[');
+    NewLine();
+    has_items_.push_back(false);
+}
+
+void Writer::EndArray() {
+    has_items_.pop_back();
+    NewLine();
+    Indent(has_items_.size());
+    Put(']');
+}
+
+void Writer::StartObject() {
+    BeforeValue();
+    Put('{');
+    NewLine();
+    has_items_.push_back(false);
+}
+
+void Writer::Key(string_view key) {
+    BeforeValue();
+    WriteEscaped(key);
+    Append(compact_ ? ":"sv : ": "sv);
+    after_key_ = true;
+}
+
+void Writer::EndObject() {
+    has_items_.pop_back();
+    NewLine();
+    Indent(has_items_.size());
+    Put('}');
+}
+
+void Writer::WriteRaw(string_view text) {
+    Append(text);
+}
+
+void Writer::Flush() {
+    if (!buffer_.empty()) {
+        WriteDirect(buffer_);
+        buffer_.clear();
+    }
+}
+
+void Writer::BeforeValue() {
+    if (after_key_) {
+        after_key_ = false;
+        return;
+    }
+    if (has_items_.empty()) {
+        return;
+    }
+    if (has_items_.back()) {
+        Put(',');
+        NewLine();
+    }
+    has_items_.back() = true;
+    Indent(has_items_.size());
+}
+
+void Writer::NewLine() {
+    if (!compact_) {
+        Put('\n');
+    }
+}
+
+void Writer::Indent(size_t depth) {
+    static constexpr string_view spaces = "                                "sv;
+    for (size_t width = depth * indent_; width > 0;) {
+        const size_t chunk = min(width, spaces.size());
+        Append(spaces.substr(0, chunk));
+        width -= chunk;
+    }
+}
+
+void Writer::WriteEscaped(string_view str) {
+    Put('"');
+    const char* pos = str.data();
+    const char* const end = pos + str.size();
+    while (pos != end) {
+        // Участки без спецсимволов копируются целиком
+        const char* special = detail::FindStringSpecial(pos, end);
+        Append(string_view(pos, static_cast<size_t>(special - pos)));
+        if (special == end) {
+            break;
+        }
+        switch (*special) {
+        case '\n': Append("\\n"sv); break;
+        case '\r': Append("\\r"sv); break;
+        case '\t': Append("\\t"sv); break;
+        case '"': Append("\\\""sv); break;
+        case '\\': Append("\\\\"sv); break;
+        default: Put(*special);
+        }
+        pos = special + 1;
+    }
+    Put('"');
+}
+
+template <typename Number>
+void Writer::WriteNumber(Number value) {
+    char digits[24];
+    const auto result = to_chars(begin(digits), end(digits), value);
+    Append(string_view(digits, static_cast<size_t>(result.ptr - digits)));
+}
+
+void Writer::WriteDirect(string_view text) {
+    output_.write(text.data(), static_cast<streamsize>(text.size()));
+}
+
+}  // namespace json
@@ -0,0 +1,96 @@
+#pragma once
+
+#include "json.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace json {
+
+struct WriterOptions {
+    // Компактный вывод в одну строку, без переводов строк и отступов
+    bool compact = false;
+    // Ширина отступа одного уровня вложенности в обычном режиме
+    int indent = 4;
+    // Размер собственного буфера; он сбрасывается в поток целиком
+    size_t buffer_size = size_t{1} << 16;
+};
+
+// Запись JSON через собственный буфер. Методы событий совпадают с событиями
+// парсера, поэтому Writer может служить обработчиком разбора и принимать
+// значения по одному. Несколько значений верхнего уровня записываются подряд
+// без разделителей. Остаток буфера сбрасывается в Flush и в деструкторе.
+class Writer {
+public:
+    explicit Writer(std::ostream& output, const WriterOptions& options = {});
+    ~Writer();
+
+    Writer(const Writer&) = delete;
+    Writer& operator=(const Writer&) = delete;
+
+    void Write(const Node& node);
+
+    void Null();
+    void Bool(bool value);
+    void Int(int value);
+    void Int64(int64_t value);
+    void Uint64(uint64_t value);
+    void Double(double value);
+    void String(std::string_view value);
+
+    void StartArray();
+    void EndArray();
+    void StartObject();
+    void Key(std::string_view key);
+    void EndObject();
+
+    // Дописывает текст как есть, например перевод строки между документами
+    void WriteRaw(std::string_view text);
+
+    void Flush();
+
+private:
+    // Разделитель и отступ перед очередным значением или ключом
+    void BeforeValue();
+    void NewLine();
+    void Indent(size_t depth);
+    void WriteEscaped(std::string_view str);
+    template <typename Number>
+    void WriteNumber(Number value);
+
+    void Append(std::string_view text) {
+        if (buffer_.size() + text.size() > buffer_size_) {
+            Flush();
+            if (text.size() > buffer_size_) {
+                WriteDirect(text);
+                return;
+            }
+        }
+        buffer_.append(text);
+    }
+
+    void Put(char c) {
+        if (buffer_.size() == buffer_size_) {
+            Flush();
+        }
+        buffer_.push_back(c);
+    }
+
+    void WriteDirect(std::string_view text);
+
+    std::ostream& output_;
+    const bool compact_;
+    const size_t indent_;
+    const size_t buffer_size_;
+    std::string buffer_;
+    // По флагу на открытый контейнер: были ли в нём уже элементы
+    std::vector<bool> has_items_;
+    // Ключ записан, значение идёт следом без разделителя
+    bool after_key_ = false;
+};
+
+}  // namespace json
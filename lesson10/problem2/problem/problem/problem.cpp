@@ -1,10 +1,36 @@
-﻿#include <cassert>
+﻿#include <algorithm>
+#include <cassert>
+#include <climits>
 #include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <optional>
 #include <sstream>
+#include <system_error>
 #include <string_view>
+#include <unordered_set>
+#include <utility>
 #include <iostream>
 
+#include "heap_stats.h"
 #include "json.h"
+#include "json_binary.h"
+#include "json_builder.h"
+#include "json_file.h"
+#include "json_lazy.h"
+#include "json_ndjson.h"
+#include "json_parallel.h"
+#include "json_path.h"
+#include "json_push.h"
+#include "json_sax.h"
+#include "json_snapshot.h"
+#include "json_stream.h"
+#include "json_tape.h"
+#include "json_writer.h"
 
 using namespace json;
 using namespace std::literals;
@@ -27,6 +53,23 @@ namespace {
         return out.str();
     }
 
+    Array MakeRecords(int count) {
+        Array arr;
+        arr.reserve(count);
+        for (int i = 0; i < count; ++i) {
+            arr.emplace_back(Dict{
+                {"int"s, 42},
+                {"double"s, 42.1},
+                {"null"s, nullptr},
+                {"string"s, "hello"s},
+                {"array"s, Array{1, 2, 3}},
+                {"bool"s, true},
+                {"map"s, Dict{{"key"s, "value"s}}},
+            });
+        }
+        return arr;
+    }
+
     void MustFailToLoad(const std::string& s) {
         try {
             LoadJSON(s);
@@ -121,6 +164,52 @@ namespace {
         assert(LoadJSON(" \t\r\n\n\r 0.0 \t\r\n\n\r ").GetRoot() == Node{0.0});
     }
 
+    // Целые за пределами int не теряют точность
+    void TestInt64() {
+        const int64_t id = 9'007'199'254'740'993;  // 2^53 + 1 не представимо в double точно
+        const Node id_node = LoadJSON("9007199254740993"s).GetRoot();
+        assert(!id_node.IsInt() && id_node.IsInt64() && id_node.IsUint64());
+        assert(id_node.AsInt64() == id);
+        assert(id_node.IsDouble() && !id_node.IsPureDouble());
+        assert(Print(id_node) == "9007199254740993"s);
+
+        assert(LoadJSON("2147483647"s).GetRoot().IsInt());
+        assert(LoadJSON("2147483648"s).GetRoot().AsInt64() == 2147483648LL);
+        assert(LoadJSON("-2147483648"s).GetRoot().IsInt());
+        assert(LoadJSON("-2147483649"s).GetRoot().AsInt64() == -2147483649LL);
+        assert(LoadJSON("9223372036854775807"s).GetRoot().AsInt64() == INT64_MAX);
+        assert(LoadJSON("-9223372036854775808"s).GetRoot().AsInt64() == INT64_MIN);
+
+        const Node max_node = LoadJSON("18446744073709551615"s).GetRoot();
+        assert(!max_node.IsInt64() && max_node.AsUint64() == UINT64_MAX);
+        assert(Print(max_node) == "18446744073709551615"s);
+        MustThrowLogicError([&max_node] {
+            max_node.AsInt64();
+        });
+        MustThrowLogicError([] {
+            Node{-1}.AsUint64();
+        });
+
+        // Не помещающиеся в 64 бита целые становятся double
+        assert(LoadJSON("18446744073709551616"s).GetRoot().IsPureDouble());
+        assert(LoadJSON("-9223372036854775809"s).GetRoot().IsPureDouble());
+        MustFailToLoad("1e999"s);
+
+        const std::string text = R"([2147483648, -9223372036854775808, 18446744073709551615, 1])"s;
+        const Node root = LoadJSON(text).GetRoot();
+        assert(LoadJSON(Print(root)).GetRoot() == root);
+
+        const TapeDocument tape = LoadTape(text);
+        const ArrayRef arr = tape.GetRoot().AsArray();
+        assert(arr[0].AsInt64() == 2147483648LL && arr[0].AsUint64() == 2147483648ULL);
+        assert(arr[1].AsInt64() == INT64_MIN && !arr[1].IsUint64());
+        assert(arr[2].AsUint64() == UINT64_MAX && !arr[2].IsInt64());
+        assert(arr[3].IsInt() && arr[3].AsInt64() == 1);
+        assert(arr[2].AsDouble() == static_cast<double>(UINT64_MAX));
+        assert(tape.ToDocument().GetRoot() == root);
+        assert(TapeDocument(root).GetRoot().ToNode() == root);
+    }
+
     void TestStrings() {
         Node str_node{"Hello, \"everybody\""s};
         assert(str_node.IsString());
@@ -196,6 +285,1241 @@ namespace {
         //assert(LoadJSON("{\"42\":42,\"4.2\":4.2,\"true\":true,\"string\":\"string\",\"[]\":[]}"s).GetRoot() == dict_node1);
     }
 
+    // Словарь из count ключей по убыванию; первый ключ повторяется в конце
+    std::string MakeReversedKeys(int count) {
+        std::string text = "{"s;
+        char key[16];
+        for (int i = count - 1; i >= 0; --i) {
+            std::snprintf(key, sizeof(key), "k%06d", i);
+            text += "\""s + key + "\": "s + std::to_string(i) + ", "s;
+        }
+        return text + "\"k000000\": -1}"s;
+    }
+
+    // Dict ведёт себя как std::map: ключи упорядочены, повторы не допускаются
+    void TestDictSemantics() {
+        Dict dict{{"b"s, 2}, {"a"s, 1}, {"b"s, 3}};
+        assert(dict.size() == 2);
+        assert(dict.at("b"sv).AsInt() == 2);
+
+        dict.insert_or_assign("b"s, 4);
+        dict["c"sv] = "x"s;
+        assert(dict.try_emplace("a"sv, 100).second == false);
+        assert(dict.emplace("0"sv, nullptr).second);
+        std::string keys;
+        for (const auto& [key, value] : dict) {
+            keys += key;
+        }
+        assert(keys == "0abc"s);
+        assert(dict.at("b"sv).AsInt() == 4 && dict.at("c"sv).AsString() == "x"s);
+        assert(dict.count("a"sv) == 1 && dict.find("z"sv) == dict.end());
+        assert(dict.erase("0"sv) == 1 && dict.erase("0"sv) == 0);
+
+        const Dict& const_dict = dict;
+        try {
+            const_dict.at("z"sv);
+            assert(false);
+        } catch (const std::out_of_range&) {
+            // ok
+        }
+
+        // Из повторяющихся при разборе ключей остаётся последний, порядок не важен
+        const Node loaded = LoadJSON(R"({"c": 1, "a": 2, "b": 3, "a": 4})"s).GetRoot();
+        assert((loaded == Node{Dict{{"a"s, 4}, {"b"s, 3}, {"c"s, 1}}}));
+
+        // Ключи по убыванию сортируются один раз на словарь, а не вставляются
+        // по одному в середину: 100000 ключей загружаются за линейно-логарифмическое время
+        const std::string reversed = MakeReversedKeys(100'000);
+        const auto check_reversed = [](const Node& root) {
+            const Dict& reversed_dict = root.AsMap();
+            assert(reversed_dict.size() == 100'000);
+            assert(std::is_sorted(reversed_dict.begin(), reversed_dict.end(), [](const auto& lhs, const auto& rhs) {
+                return lhs.first.View() < rhs.first.View();
+            }));
+            assert(reversed_dict.at("k000000"sv).AsInt() == -1 && reversed_dict.at("k099999"sv).AsInt() == 99'999);
+        };
+        check_reversed(LoadJSON(reversed).GetRoot());
+        PushParser push_parser;
+        push_parser.Feed(reversed);
+        push_parser.Finish();
+        check_reversed(push_parser.TakeDocument().GetRoot());
+    }
+
+    // Длинные ключи одной загрузки разделяют память, Key находит поле в любом словаре
+    void TestKeys() {
+        const Symbol short_key("int"sv);
+        const Symbol long_key("a_rather_long_dictionary_key"s);
+        assert(short_key == "int"sv && "int"s == short_key && short_key != long_key);
+        assert(Symbol(long_key) == long_key && Symbol(long_key.View()) == long_key);
+        assert(Symbol{} == ""sv && Symbol{}.empty() && Symbol(std::string_view{}) == Symbol{});
+
+        const Document doc = json::Load(
+            R"([{"a_rather_long_dictionary_key": 1, "x": 2}, {"x": 3, "a_rather_long_dictionary_key": 4}])"sv);
+        const Array& records = doc.GetRoot().AsArray();
+        const Symbol& first = records[0].AsMap().begin()->first;
+        const Symbol& second = records[1].AsMap().begin()->first;
+        assert(first == long_key && first.View().data() == second.View().data());
+
+        const Key long_field(long_key.View());
+        const Key x("x"sv);
+        const Key missing("missing"sv);
+        int sum = 0;
+        for (const Node& record : records) {
+            sum += record.AsMap().at(long_field).AsInt() + record.AsMap().at(x).AsInt();
+        }
+        assert(sum == 10);
+        // Словарь другой формы: позиция из прошлого поиска не подходит
+        const Dict other{{"0"s, 0}, {"1"s, 1}, {"x"s, 5}};
+        assert(other.at(x).AsInt() == 5 && other.find(missing) == other.end());
+        try {
+            other.at(missing);
+            assert(false);
+        } catch (const std::out_of_range&) {
+            // ok
+        }
+
+        const TapeDocument tape{doc};
+        assert(tape.GetRoot().ToNode() == doc.GetRoot());
+    }
+
+    void TestHash() {
+        const std::string text = R"([{"a": [1, 2.5, "s"], "b": null}, {"a": [1, 2.5, "s"], "b": null}, -0.0])"s;
+        const Document loaded = json::Load(text);
+        const Document borrowed = json::Load(text, LoadOptions{.borrow_strings = true});
+        const Node& root = loaded.GetRoot();
+        assert(root.Hash() == borrowed.GetRoot().Hash());
+        assert(Node{0.0}.Hash() == Node{-0.0}.Hash() && Node{"s"s}.Hash() == Node::BorrowString("s"sv).Hash());
+        assert(root.AsArray()[0].Hash() == root.AsArray()[1].Hash());
+
+        // Значения разных типов и разной структуры различаются
+        const std::vector<Node> distinct{nullptr, false, true, 0, 1, 0.5, ""s, "0"s, Array{}, Dict{}, Array{0},
+                                         Array{Array{}}, Dict{{"0"s, 0}}, Dict{{""s, Array{}}}};
+        std::unordered_set<size_t> hashes;
+        for (const Node& node : distinct) {
+            hashes.insert(std::hash<Node>{}(node));
+        }
+        assert(hashes.size() == distinct.size());
+
+        std::unordered_set<Node> unique(root.AsArray().begin(), root.AsArray().end());
+        assert(unique.size() == 2 && unique.count(Node{-0.0}) == 1);
+        assert(unique.count(json::Load(R"({"b": null, "a": [1, 2.5, "s"]})"sv).GetRoot()) == 1);
+
+        // Вычисленный хэш копируется, и сравнение с другим деревом не обходит его
+        const Node copy = root;
+        assert(copy == root && copy.Hash() == root.Hash());
+        const Node other = json::Load(R"([{"a": [1, 2.5, "s"], "b": null}, {"a": [1, 2.5, "t"], "b": null}, 0])"sv)
+                               .GetRoot();
+        assert(other != root && other.Hash() != root.Hash() && other != root);
+        assert(other.AsArray()[0] == root.AsArray()[0]);
+        Node moved = copy;
+        const Node target = std::move(moved);
+        assert(target == root && target.Hash() == root.Hash());
+    }
+
+    void TestNodeLayout() {
+        static_assert(sizeof(Node) == 16);
+        const std::vector<std::pair<Node, Node::Type>> typed{
+            {nullptr, Node::Type::Null},           {true, Node::Type::Bool},
+            {1, Node::Type::Int},                  {int64_t{1} << 40, Node::Type::Int64},
+            {uint64_t{UINT64_MAX}, Node::Type::Uint64}, {0.5, Node::Type::Double},
+            {"short"s, Node::Type::String},        {std::string(100, 'x'), Node::Type::String},
+            {Node::BorrowString("b"sv), Node::Type::String}, {Array{}, Node::Type::Array},
+            {Dict{}, Node::Type::Dict},            {Node::Share(Array{1}), Node::Type::Array}};
+        for (const auto& [node, type] : typed) {
+            assert(node.GetType() == type);
+        }
+
+        // Граница строки, хранимой в самом узле
+        const std::string inline_text(Node::kInlineStringCapacity, 'a');
+        const std::string heap_text(Node::kInlineStringCapacity + 1, 'b');
+        const Node inline_node{inline_text};
+        const Node heap_node{heap_text};
+        assert(inline_node.AsString() == inline_text && heap_node.AsString() == heap_text);
+        assert(Node{""s}.AsString().empty() && Node{""s} == Node::BorrowString(""sv));
+
+        // Копия длинной строки и контейнера не зависит от оригинала
+        std::optional<Node> original{Array{heap_text, inline_text, Dict{{"k"s, heap_text}}}};
+        const Node copy = *original;
+        assert(&copy.AsArray() != &original->AsArray() && copy.AsArray()[0].AsString().data() != heap_text.data());
+        original.reset();
+        assert(copy.AsArray()[0].AsString() == heap_text && copy.AsArray()[2].AsMap().at("k"sv).AsString() == heap_text);
+
+        // Перемещение не копирует блок и оставляет null
+        Node source = copy;
+        const Array* block = &source.AsArray();
+        Node target = std::move(source);
+        assert(&target.AsArray() == block && source.IsNull());
+        target = target;
+        target = std::move(target);
+        assert(target == copy);
+        target = 7;
+        assert(target.AsInt() == 7);
+
+        // Копия контейнера из арены размещается в обычной куче
+        const Document doc = json::Load(R"([[1, 2], {"a": "a string long enough"}])"sv, LoadOptions{.use_arena = true});
+        const Node heap_copy = doc.GetRoot();
+        assert(heap_copy.AsArray().get_allocator().resource() == std::pmr::get_default_resource());
+        assert(heap_copy == doc.GetRoot() && heap_copy.AsArray()[1].AsMap().at("a"sv).AsString() == "a string long enough"sv);
+    }
+
+    void TestMutableAccess() {
+        const std::string text = Print(Node{MakeRecords(3)});
+        const Document plain = json::Load(text);
+
+        // Изменение на месте сбрасывает кэш хэша на всём пути от корня
+        Document doc = json::Load(text);
+        const size_t hash = doc.GetRoot().Hash();
+        doc.GetRoot().AsMutableArray()[1].AsMutableMap()["int"s] = 43;
+        assert(doc != plain && doc.GetRoot().Hash() != hash);
+        doc.GetRoot().AsMutableArray()[1].AsMutableMap()["int"s] = 42;
+        assert(doc == plain && doc.GetRoot().Hash() == hash);
+        doc.GetRoot().AsMutableArray().push_back("new"s);
+        assert(doc.GetRoot().AsArray().size() == 4 && doc.GetRoot().Hash() != hash);
+
+        // Изменение по сохранённой ссылке после Hash() у родителя
+        Node nested{Array{Array{1}}};
+        const Node expected{Array{Array{1, 2}}};
+        expected.Hash();
+        Array& outer = nested.AsMutableArray();
+        Array& inner = outer[0].AsMutableArray();
+        nested.Hash();
+        inner.push_back(2);
+        assert(nested == expected && nested.Hash() == expected.Hash());
+        // Копия снова кэширует хэш
+        const Node nested_copy = nested;
+        assert(nested_copy.Hash() == expected.Hash() && nested_copy == expected);
+
+        // Контейнер забирается без копирования
+        Node record = plain.GetRoot().AsArray()[0];
+        const Node* value = &record.AsMap().begin()->second;
+        Dict taken = record.TakeMap();
+        assert(record.IsNull() && &taken.begin()->second == value && taken.size() == 7 && taken.at("int"sv).AsInt() == 42);
+        Node array_node{Array{1, 2, 3}};
+        const Node* first = &array_node.AsArray()[0];
+        const Array items = std::move(array_node).AsArray();
+        assert(&items[0] == first && array_node.IsNull());
+        assert((Node{Dict{{"k"s, 1}}}.AsMap().at("k"sv).AsInt() == 1));
+        try {
+            Node{1}.AsMutableArray();
+            assert(false);
+        } catch (const std::logic_error&) {
+            // ok
+        }
+
+        // Изменение общего поддерева не затрагивает другие узлы, а
+        // единственный владелец забирает поддерево без копирования
+        const Node shared = Node::Share(Node{std::move(taken)});
+        Node copy = shared;
+        copy.AsMutableMap()["int"s] = 0;
+        assert(!copy.IsShared() && shared.AsMap().at("int"sv).AsInt() == 42 && copy.AsMap().at("int"sv).AsInt() == 0);
+        Node owner = Node::Share(Node{Array{1}});
+        const Array* owned = &owner.AsArray();
+        owner.Unshare();
+        assert(!owner.IsShared() && &owner.AsArray() == owned);
+
+        // Дерево без арены и заимствованных строк забирается как есть
+        Document source = json::Load(text);
+        const Array* root_block = &source.GetRoot().AsArray();
+        const Node root = std::move(source).ExtractRoot();
+        assert(&root.AsArray() == root_block && root == plain.GetRoot() && source.GetRoot().IsNull());
+
+        // Дерево из арены и заимствованные строки не зависят от документа
+        std::optional<Node> extracted;
+        {
+            Document borrowed = LoadBuffer(text, LoadOptions{.use_arena = true, .borrow_strings = true});
+            extracted = std::move(borrowed).ExtractRoot();
+        }
+        assert(*extracted == plain.GetRoot() && !extracted->AsArray()[0].AsMap().at("string"sv).IsBorrowedString());
+        {
+            Document deduplicated = LoadBuffer(text, LoadOptions{.borrow_strings = true, .deduplicate = true});
+            extracted = std::move(deduplicated).ExtractRoot();
+        }
+        const Array& records = extracted->AsArray();
+        assert(*extracted == plain.GetRoot() && records[0].IsShared() && &records[0].AsMap() == &records[2].AsMap());
+    }
+
+    void TestDeduplicate() {
+        const std::string text = Print(Node{MakeRecords(3)});
+        const Document plain = json::Load(text);
+        const Document doc = json::Load(text, LoadOptions{.use_arena = true, .deduplicate = true});
+        assert(doc == plain && !doc.HasArena());
+
+        // Одинаковые записи и их вложенные контейнеры — одно поддерево
+        const Node& root = doc.GetRoot();
+        const Array& records = root.AsArray();
+        assert(!root.IsShared() && records[0].IsShared() && records[2].IsShared());
+        assert(&records[0].AsMap() == &records[2].AsMap());
+        assert(&records[0].AsMap().at("map"sv).AsMap() == &records[1].AsMap().at("map"sv).AsMap());
+        assert(records[0] == plain.GetRoot().AsArray()[0] && records[0].Hash() == plain.GetRoot().AsArray()[0].Hash());
+        assert(records[0].AsMap().at("int"sv).AsInt() == 42 && records[1].AsMap().at("string"sv).AsString() == "hello"sv);
+
+        // Пустые контейнеры и скаляры не разделяются
+        const Document small = json::Load("[[], [], {}, {}, [1], [1]]"sv, LoadOptions{.deduplicate = true});
+        const Array& items = small.GetRoot().AsArray();
+        assert(!items[0].IsShared() && !items[2].IsShared() && items[4].IsShared() && items[5].IsShared());
+
+        Document compacted = json::Load(text, LoadOptions{.use_arena = true});
+        assert(compacted.HasArena());
+        assert(Compact(compacted) > 0);
+        assert(!compacted.HasArena() && compacted == plain);
+        assert(&compacted.GetRoot().AsArray()[0].AsMap() == &compacted.GetRoot().AsArray()[1].AsMap());
+        // Повторное сжатие ничего не освобождает
+        assert(Compact(compacted) == 0 && compacted == plain);
+
+        std::ostringstream out;
+        SaveBinary(plain, out);
+        const Document binary = LoadBinary(out.str(), LoadOptions{.deduplicate = true});
+        assert(binary == plain && binary.GetRoot().AsArray()[1].IsShared());
+
+        // Общее поддерево из арены переживает свой документ
+        std::optional<Node> shared;
+        {
+            const Document arena_doc = json::Load(text, LoadOptions{.use_arena = true});
+            shared = Node::Share(arena_doc.GetRoot().AsArray()[0]);
+        }
+        const Node copy = *shared;
+        assert(copy.IsShared() && &copy.AsMap() == &shared->AsMap() && copy == plain.GetRoot().AsArray()[0]);
+        const Node reshared = Node::Share(copy);
+        assert(reshared.IsShared() && &reshared.AsMap() == &copy.AsMap());
+    }
+
+    void TestPersistent() {
+        const std::string text
+            = R"({"server": {"host": "localhost", "port": 8080, "tls": {"enabled": false}}, "db": {"pool": [1, 2, 3]}})"s;
+        const Document plain = json::Load(text);
+        Document config = json::Load(text, LoadOptions{.use_arena = true});
+        Persist(config);
+        assert(!config.HasArena() && config == plain && config.GetRoot().IsShared());
+
+        // Копия разделяет всё дерево
+        Document handler = config;
+        const Node& root = std::as_const(config).GetRoot();
+        assert(&handler.GetRoot().AsMap() == &root.AsMap());
+
+        // Правка копирует только путь до изменённого узла
+        handler.GetRoot().AsMutableMap()["server"s].AsMutableMap()["tls"s].AsMutableMap()["enabled"s] = true;
+        const Node& edited = handler.GetRoot();
+        assert(config == plain && handler != plain);
+        assert(edited.AsMap().at("server"sv).AsMap().at("tls"sv).AsMap().at("enabled"sv).AsBool());
+        assert(&edited.AsMap().at("db"sv).AsMap() == &root.AsMap().at("db"sv).AsMap());
+        assert(&edited.AsMap().at("server"sv).AsMap() != &root.AsMap().at("server"sv).AsMap());
+        assert(!edited.IsShared() && edited.AsMap().at("db"sv).IsShared());
+
+        // Повторный Persist снова делает копию O(1) и не трогает общие поддеревья
+        Persist(handler);
+        const Document next = handler;
+        assert(next.GetRoot().IsShared() && &next.GetRoot().AsMap() == &handler.GetRoot().AsMap());
+        assert(&next.GetRoot().AsMap().at("db"sv).AsMap() == &root.AsMap().at("db"sv).AsMap());
+
+        // Скаляры и уже общие узлы возвращаются как есть
+        assert(Node::Persist(1).AsInt() == 1 && Node::Persist(Array{}).IsShared());
+        const Node shared = Node::Share(Array{Array{1}});
+        const Node persisted = Node::Persist(shared);
+        assert(&persisted.AsArray() == &shared.AsArray());
+    }
+
+    void TestLoadFromStringView() {
+        const Node arr_node{Array{1, 1.23, "Hello"s, Dict{{"key"s, nullptr}}}};
+        assert(json::Load(R"( [1, 1.23, "Hello", {"key": null}] )"sv).GetRoot() == arr_node);
+        assert(json::Load(Print(arr_node)).GetRoot() == arr_node);
+
+        // Разбор не должен выходить за границы переданного буфера
+        const std::string text = "[1, 2]3"s;
+        assert(json::Load(std::string_view(text).substr(0, 6)).GetRoot() == (Node{Array{1, 2}}));
+    }
+
+    // Строки без экранирования ссылаются на буфер, остальные копируются
+    void TestBorrowedStrings() {
+        const std::string text = R"(["a string long enough to leave SSO", "esc\"aped", {"key": "value"}])"s;
+        const Document doc = json::Load(text, LoadOptions{.borrow_strings = true});
+        const Array& arr = doc.GetRoot().AsArray();
+        assert(arr[0].IsBorrowedString() && arr[0].AsString().data() == text.data() + 2);
+        assert(!arr[1].IsBorrowedString() && arr[1].AsString() == "esc\"aped"sv);
+        assert(arr[2].AsMap().at("key"sv).IsBorrowedString());
+        assert(doc.GetRoot() == json::Load(text).GetRoot());
+        assert(!json::Load(text).GetRoot().AsArray()[0].IsBorrowedString());
+
+        // Из потока строки всегда копируются: его буфер временный
+        std::istringstream strm(text);
+        assert(!json::Load(strm, LoadOptions{.borrow_strings = true}).GetRoot().AsArray()[0].IsBorrowedString());
+
+        // LoadBuffer по умолчанию копирует строки, и узел переживает документ
+        const Node node = LoadBuffer(text).GetRoot();
+        assert(!node.AsArray()[0].IsBorrowedString() && node == doc.GetRoot());
+        assert(!LoadBuffer(text).OwnsInput());
+
+        // С borrow_strings LoadBuffer держит текст, пока жив документ или его копия
+        std::optional<Document> copy;
+        {
+            Document owner = LoadBuffer(text, LoadOptions{.use_arena = true, .borrow_strings = true});
+            assert(owner.OwnsInput() && owner.GetRoot().AsArray()[0].IsBorrowedString());
+            copy = owner;
+        }
+        assert(copy->OwnsInput() && copy->GetRoot() == doc.GetRoot());
+        std::ostringstream out;
+        PrintCompact(*copy, out);
+        assert(out.str() == R"(["a string long enough to leave SSO","esc\"aped",{"key":"value"}])"s);
+    }
+
+    // Пишет text во временный файл и возвращает его путь
+    std::filesystem::path WriteTempFile(const std::string& name, std::string_view text) {
+        const std::filesystem::path path = std::filesystem::temp_directory_path() / name;
+        std::ofstream out(path, std::ios::binary);
+        out.write(text.data(), static_cast<std::streamsize>(text.size()));
+        return path;
+    }
+
+    void TestLoadFile() {
+        const std::string text = R"(["a string long enough to leave SSO", "esc\"aped", {"key": 1.5}])"s;
+        const std::filesystem::path path = WriteTempFile("json_load_file_test.json", text);
+        std::optional<Document> copy;
+        {
+            const Document doc = LoadFile(path, LoadOptions{.use_arena = true, .borrow_strings = true});
+            assert(doc.OwnsInput() && doc.HasArena());
+            assert(doc.GetRoot() == json::Load(text).GetRoot());
+            assert(doc.GetRoot().AsArray()[0].IsBorrowedString());
+            copy = doc;
+        }
+        // Копия удерживает отображение после разрушения оригинала
+        assert(copy->GetRoot().AsArray()[0].AsString() == "a string long enough to leave SSO"sv);
+        // Без borrow_strings узел не зависит от отображения
+        const Node node = LoadFile(path).GetRoot();
+        assert(!LoadFile(path).OwnsInput() && !node.AsArray()[0].IsBorrowedString());
+        assert(node.AsArray()[0].AsString() == "a string long enough to leave SSO"sv);
+
+        const MappedFile file(path);
+        assert(file.GetText() == text && file.GetSize() == text.size());
+
+        const std::filesystem::path empty = WriteTempFile("json_load_file_empty.json", ""sv);
+        assert(MappedFile(empty).GetText().empty());
+        try {
+            LoadFile(empty);
+            assert(false);
+        } catch (const ParsingError&) {
+            // ok
+        }
+        std::filesystem::remove(path);
+        std::filesystem::remove(empty);
+        try {
+            LoadFile(path);
+            assert(false);
+        } catch (const std::system_error&) {
+            // ok
+        }
+    }
+
+    void TestBinary() {
+        Dict dict{{"a"s, 1}, {"a key long enough to be shared"s, Array{int64_t{-5}, uint64_t{5}}}};
+        dict.try_emplace("nested"s, Dict{{"a key long enough to be shared"s, nullptr}});
+        const Node root{Array{nullptr, true, false, 0, -1, INT_MAX, INT_MIN, int64_t{INT64_MIN}, uint64_t{UINT64_MAX},
+                              1.5, -0.25, 1e300, ""s, "text"s, Node::BorrowString("borrowed"sv),
+                              std::string(300, 'x'), Array{}, Dict{}, dict}};
+        std::ostringstream out;
+        SaveBinary(Document{root}, out);
+        const std::string binary = out.str();
+        assert(binary.substr(0, 4) == "JSNB"s);
+
+        // Тип числа сохраняется: int64_t{-5} не становится int
+        const Document doc = LoadBinary(binary);
+        assert(doc.GetRoot() == root);
+        assert(doc.GetRoot().AsArray()[18].AsMap().at("a key long enough to be shared"sv).AsArray()[0].GetType()
+               == Node::Type::Int64);
+        assert(!doc.GetRoot().AsArray()[13].IsBorrowedString());
+
+        const Document borrowed = LoadBinary(binary, LoadOptions{.use_arena = true, .borrow_strings = true});
+        assert(borrowed.HasArena() && borrowed.GetRoot() == root);
+        assert(borrowed.GetRoot().AsArray()[13].IsBorrowedString());
+
+        std::istringstream strm(binary);
+        const Document from_stream = LoadBinary(strm, LoadOptions{.borrow_strings = true});
+        assert(from_stream.OwnsInput() && from_stream.GetRoot() == root);
+        assert(from_stream.GetRoot().AsArray()[13].IsBorrowedString());
+
+        // Без borrow_strings узел не зависит от буфера и отображения
+        std::istringstream copied_strm(binary);
+        const Node from_copied = LoadBinary(copied_strm).GetRoot();
+        const std::filesystem::path path = WriteTempFile("json_binary_test.jsnb", binary);
+        const Node from_file = LoadBinaryFile(path).GetRoot();
+        assert(from_copied == root && !from_copied.AsArray()[13].IsBorrowedString());
+        assert(from_file == root && !from_file.AsArray()[13].IsBorrowedString());
+        assert(LoadBinaryFile(path, LoadOptions{.borrow_strings = true}).GetRoot().AsArray()[13].IsBorrowedString());
+        std::filesystem::remove(path);
+
+        // Повреждённые и обрезанные данные не читаются за пределами буфера
+        for (size_t size = 0; size < binary.size(); ++size) {
+            try {
+                LoadBinary(std::string_view(binary).substr(0, size));
+                assert(false);
+            } catch (const ParsingError&) {
+                // ok
+            }
+        }
+        for (const std::string_view bad : {"JSON\x01\x00"sv, "JSNB\x02\x00"sv, "JSNB\x01\x0a"sv,
+                                           "JSNB\x01\x08\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\x01"sv}) {
+            try {
+                LoadBinary(bad);
+                assert(false);
+            } catch (const ParsingError&) {
+                // ok
+            }
+        }
+    }
+
+    void TestSnapshot() {
+        Dict dict{{"b"s, 1}, {"a key long enough to be shared"s, Array{int64_t{-5}, uint64_t{5}}}, {"a"s, "text"s}};
+        const Node root{Array{nullptr, true, false, INT_MIN, int64_t{INT64_MIN}, uint64_t{UINT64_MAX}, -0.25,
+                              std::string(300, 'x'), Array{}, Dict{}, dict, dict}};
+        std::ostringstream out;
+        Snapshot::Save(Document{root}, out);
+        const std::string image = out.str();
+
+        const Snapshot snapshot(image);
+        const SnapshotNode view = snapshot.GetRoot();
+        assert(view.IsArray() && !view.IsMap() && view.AsArray().size() == 12);
+        assert(view.ToNode() == root);
+
+        const SnapshotArray arr = view.AsArray();
+        assert(arr[0].IsNull() && arr[1].AsBool() && !arr[2].AsBool());
+        assert(arr[3].IsInt() && arr[3].AsInt() == INT_MIN && arr[3].AsDouble() == INT_MIN);
+        assert(!arr[4].IsInt() && arr[4].AsInt64() == INT64_MIN && !arr[4].IsUint64());
+        assert(!arr[5].IsInt64() && arr[5].AsUint64() == UINT64_MAX);
+        assert(arr[6].IsPureDouble() && arr[6].AsDouble() == -0.25);
+        assert(arr[7].AsString() == std::string(300, 'x'));
+        assert(arr[8].AsArray().empty() && arr[9].AsMap().empty());
+        // Строки читаются прямо из образа
+        assert(arr[7].AsString().data() > image.data() && arr[7].AsString().data() < image.data() + image.size());
+
+        const SnapshotDict map = arr[10].AsMap();
+        assert(map.size() == 3 && map.count("a"sv) == 1 && map.count("c"sv) == 0 && map.count(""sv) == 0);
+        assert(map.at("b"sv).AsInt() == 1 && map.at("a"sv).AsString() == "text"sv);
+        const SnapshotArray nested = map.at("a key long enough to be shared"sv).AsArray();
+        assert(nested.at(0).AsInt64() == -5 && nested.at(1).IsUint64());
+        std::vector<std::string_view> keys;
+        for (const auto& [key, value] : map) {
+            keys.push_back(key);
+        }
+        assert((keys == std::vector{"a"sv, "a key long enough to be shared"sv, "b"sv}));
+        // Одинаковые ключи двух словарей хранятся один раз
+        assert((*arr[11].AsMap().begin()).first.data() == keys[0].data());
+        int sum = 0;
+        for (const SnapshotNode item : nested) {
+            sum += static_cast<int>(item.AsInt64());
+        }
+        assert(sum == 0);
+
+        MustThrowLogicError([&arr] {
+            arr[0].AsInt();
+        });
+        MustThrowLogicError([&arr] {
+            arr[5].AsInt64();
+        });
+        try {
+            arr.at(12);
+            assert(false);
+        } catch (const std::out_of_range&) {
+            // ok
+        }
+        try {
+            map.at("c"sv);
+            assert(false);
+        } catch (const std::out_of_range&) {
+            // ok
+        }
+
+        const std::filesystem::path path = std::filesystem::temp_directory_path() / "json_snapshot_test.jsns";
+        Snapshot::Save(Document{root}, path);
+        {
+            const Snapshot opened = Snapshot::Open(path);
+            assert(opened.GetSize() == image.size() && opened.GetRoot().ToNode() == root);
+        }
+        std::filesystem::remove(path);
+
+        // Обрезанный или чужой образ не открывается, испорченное смещение
+        // обнаруживается при обращении
+        for (const std::string_view bad : {""sv, std::string_view(image).substr(0, image.size() - 8),
+                                           "JSON and some more bytes to fill the header"sv}) {
+            try {
+                Snapshot{bad};
+                assert(false);
+            } catch (const ParsingError&) {
+                // ok
+            }
+        }
+        std::string corrupted = image;
+        const uint64_t offset = uint64_t{1} << 40;
+        std::memcpy(corrupted.data() + 24, &offset, sizeof(offset));
+        try {
+            Snapshot(corrupted).GetRoot().AsArray();
+            assert(false);
+        } catch (const ParsingError&) {
+            // ok
+        }
+    }
+
+    void TestLongStringsAndWhitespace() {
+        // Длины подобраны так, чтобы спецсимволы попадали на границы 16- и 32-байтных блоков
+        for (size_t len = 0; len < 80; ++len) {
+            const std::string plain(len, 'a');
+            const std::string padding(len, len % 2 == 0 ? ' ' : '\t');
+
+            assert(LoadJSON(padding + '"' + plain + '"' + padding).GetRoot() == Node{plain});
+            assert(LoadJSON("[" + padding + "1," + padding + "\n2" + padding + "]").GetRoot()
+                   == (Node{Array{1, 2}}));
+
+            const std::string escaped = plain + "\"\\\n" + plain;
+            assert(LoadJSON(Print(Node{escaped})).GetRoot() == Node{escaped});
+            MustFailToLoad('"' + plain + '\n' + plain + '"');
+            MustFailToLoad('"' + plain);
+        }
+        // Байты старше 0x7F (UTF-8) не являются спецсимволами
+        const std::string utf8 = "Привет, мир! Привет, мир! Привет, мир!"s;
+        assert(LoadJSON('"' + utf8 + '"').GetRoot() == Node{utf8});
+    }
+
+    void TestArenaDocument() {
+        const std::string text = Print(Node{MakeRecords(10)});
+        const LoadOptions arena_options{.use_arena = true};
+
+        Document doc = json::Load(text, arena_options);
+        assert(doc.HasArena());
+        assert(doc == json::Load(text));
+
+        // Копия размещается в обычной куче и переживает исходный документ
+        Document copy = doc;
+        assert(!copy.HasArena());
+        assert(copy == doc);
+
+        Document moved = std::move(doc);
+        assert(moved.HasArena());
+        assert(moved == copy);
+
+        moved = json::Load("[1, 2, 3]"sv, arena_options);
+        assert(moved.GetRoot() == (Node{Array{1, 2, 3}}));
+        moved = copy;
+        assert(!moved.HasArena());
+        assert(moved == copy);
+    }
+
+    void TestTapeDocument() {
+        const Node root{Dict{
+            {"null"s, nullptr},
+            {"bool"s, false},
+            {"int"s, -42},
+            {"double"s, 2.5},
+            {"string"s, "hello"s},
+            {"array"s, Array{1, "two"s, Array{}, Dict{{"key"s, 3.5}}}},
+            {"map"s, Dict{}},
+        }};
+        const TapeDocument tape{Document{root}};
+        const NodeRef tape_root = tape.GetRoot();
+        assert(tape_root.IsMap());
+
+        const DictRef dict = tape_root.AsMap();
+        assert(dict.size() == 7);
+        assert(dict.at("null"sv).IsNull());
+        assert(!dict.at("bool"sv).AsBool());
+        assert(dict.at("int"sv).AsInt() == -42);
+        assert(dict.at("int"sv).IsDouble() && dict.at("int"sv).AsDouble() == -42.0);
+        assert(dict.at("double"sv).IsPureDouble() && dict.at("double"sv).AsDouble() == 2.5);
+        assert(dict.at("string"sv).AsString() == "hello"sv);
+        assert(dict.count("missing"sv) == 0);
+        assert(dict.at("map"sv).AsMap().empty());
+
+        const ArrayRef arr = dict.at("array"sv).AsArray();
+        assert(arr.size() == 4);
+        assert(arr[0].AsInt() == 1);
+        assert(arr.at(1).AsString() == "two"sv);
+        assert(arr[2].AsArray().empty());
+        assert(arr[3].AsMap().at("key"sv).AsDouble() == 3.5);
+
+        // Ключи перечисляются в том же порядке, что и в Dict
+        auto dict_it = root.AsMap().begin();
+        for (const auto& [key, value] : dict) {
+            assert(key == dict_it->first);
+            assert(value.ToNode() == dict_it->second);
+            ++dict_it;
+        }
+
+        assert(tape.ToDocument() == Document{root});
+        assert(LoadTape(Print(root)).ToDocument().GetRoot() == root);
+        // При разборе текста ключи упорядочиваются, из повторов остаётся последний
+        const TapeDocument parsed{R"({"b": 1, "a": 2, "b": 3})"sv};
+        assert(parsed.ToDocument().GetRoot() == (Node{Dict{{"a"s, 2}, {"b"s, 3}}}));
+        assert(parsed.GetRoot().AsMap().at("b"sv).AsInt() == 3);
+
+        MustThrowLogicError([&tape_root] {
+            tape_root.AsArray();
+        });
+        MustThrowLogicError([&arr] {
+            arr[1].AsInt();
+        });
+    }
+
+    // Записывает события разбора в строку
+    class RecordingHandler final : public json::Handler {
+    public:
+        void Null() override { out_ << "null "sv; }
+        void Bool(bool value) override { out_ << (value ? "true "sv : "false "sv); }
+        void Int(int value) override { out_ << "int:"sv << value << ' '; }
+        void Int64(int64_t value) override { out_ << "int64:"sv << value << ' '; }
+        void Uint64(uint64_t value) override { out_ << "uint64:"sv << value << ' '; }
+        void Double(double value) override { out_ << "double:"sv << value << ' '; }
+        void String(std::string_view value) override { out_ << "str:"sv << value << ' '; }
+        void StartArray() override { out_ << "[ "sv; }
+        void EndArray() override { out_ << "] "sv; }
+        void StartObject() override { out_ << "{ "sv; }
+        void Key(std::string_view key) override { out_ << "key:"sv << key << ' '; }
+        void EndObject() override { out_ << "} "sv; }
+
+        std::string GetEvents() const { return out_.str(); }
+
+    private:
+        std::ostringstream out_;
+    };
+
+    void TestLazyDocument() {
+        const std::string text = R"({"id": 7, "tags": ["a", "b\"c", 2.5], "k\"ey": null, "id": 8, "big": 1e300,
+            "nested": {"deep": [true, {"x": -9000000000}]}, "broken": [1, 2)"s;
+        const LazyDocument doc(text);
+        const LazyDict root = doc.GetRoot().AsMap();
+
+        // Обращение к началу документа не трогает испорченный хвост
+        assert(root.at("id"sv).AsInt() == 7);
+        const LazyArray tags = root.at("tags"sv).AsArray();
+        assert(tags[0].AsString() == "a"sv && tags.at(1).AsString() == "b\"c"sv && tags[2].AsDouble() == 2.5);
+        assert(tags.size() == 3 && !tags.empty());
+        // Найденные значения запоминаются
+        assert(tags[0].AsString().data() == tags[0].AsString().data());
+        assert(tags[0].AsString().data() >= text.data() && tags[0].AsString().data() < text.data() + text.size());
+        assert(root.at("k\"ey"sv).IsNull());
+        assert(root.at("big"sv).IsPureDouble());
+
+        const LazyNode deep = root.at("nested"sv).AsMap().at("deep"sv);
+        assert(deep.AsArray()[0].AsBool() && deep.AsArray()[1].AsMap().at("x"sv).AsInt64() == -9000000000);
+        assert(deep.ToNode() == (Node{Array{true, Dict{{"x"s, int64_t{-9000000000}}}}}));
+
+        std::string order;
+        for (const LazyNode tag : tags) {
+            order += tag.IsString() ? "s"s : "n"s;
+        }
+        assert(order == "ssn"s);
+        MustThrowLogicError([&tags] {
+            tags[0].AsInt();
+        });
+        try {
+            tags.at(3);
+            assert(false);
+        } catch (const std::out_of_range&) {
+            // ok
+        }
+
+        // Ошибка обнаруживается, когда до неё доходит чтение
+        try {
+            root.count("missing"sv);
+            assert(false);
+        } catch (const ParsingError&) {
+            // ok
+        }
+
+        const std::string records = Print(Node{MakeRecords(10)});
+        const LazyDocument lazy_records(records);
+        std::vector<std::string_view> keys;
+        for (const auto& [key, value] : lazy_records.GetRoot().AsArray()[3].AsMap()) {
+            keys.push_back(key);
+        }
+        assert(keys.size() == 7 && keys.front() == "array"sv);
+        assert(lazy_records.GetRoot().ToNode() == Node{MakeRecords(10)});
+    }
+
+    void TestPath() {
+        const std::string text = R"({"a": [{"b": 1}, {"b": 2}, {"c": 3}, {"b": [4]}], "x/y": {"~": 5, "0": 6},
+            "m": {"z": 7, "k": 8}})"s;
+        const Document doc = json::Load(text);
+        const Node& root = doc.GetRoot();
+
+        auto values = [&root](std::string_view expression) {
+            std::vector<Node> result;
+            for (const Node* node : Path(expression).Select(root)) {
+                result.push_back(*node);
+            }
+            return result;
+        };
+        assert(values(""sv) == std::vector<Node>{root});
+        assert(values("/a/1/b"sv) == std::vector<Node>{2});
+        assert(values("/x~1y/~0"sv) == std::vector<Node>{5});
+        // В словаре индекс — обычный ключ
+        assert(values("/x~1y/0"sv) == std::vector<Node>{6});
+        assert(values("/a/*/b"sv) == (std::vector<Node>{1, 2, Array{4}}));
+        assert(values("/a/1:/b"sv) == (std::vector<Node>{2, Array{4}}));
+        assert(values("/a/:2/b"sv) == (std::vector<Node>{1, 2}));
+        assert(values("/a/3/b/0"sv) == std::vector<Node>{4});
+        assert(values("/m/*"sv) == (std::vector<Node>{8, 7}));
+        assert(values("/a/-"sv).empty() && values("/a/01"sv).empty() && values("/a/b"sv).empty());
+        assert(values("/missing/0"sv).empty() && values("/a/0/b/c"sv).empty());
+
+        const Path first_b("/a/*/b"sv);
+        assert(first_b.Find(root) != nullptr && *first_b.Find(root) == Node{1});
+        assert(Path("/nope"sv).Find(root) == nullptr);
+        assert(first_b.GetExpression() == "/a/*/b"s);
+
+        // При разборе строятся только совпадения, в порядке текста
+        assert(first_b.Extract(text) == (std::vector<Node>{1, 2, Array{4}}));
+        assert(Path("/m/*"sv).Extract(text) == (std::vector<Node>{7, 8}));
+        assert(Path(""sv).Extract(text) == std::vector<Node>{root});
+        std::istringstream strm(text);
+        assert(Path("/a/3"sv).Extract(strm) == (std::vector<Node>{Dict{{"b"s, Array{4}}}}));
+        // Повторяющийся ключ: Select видит последнее значение, Extract — каждое
+        const std::string duplicates = R"({"k": 1, "k": 2})"s;
+        assert(*Path("/k"sv).Find(json::Load(duplicates).GetRoot()) == Node{2});
+        assert(Path("/k"sv).Extract(duplicates) == (std::vector<Node>{1, 2}));
+
+        for (const std::string_view bad : {"a"sv, "/a~"sv, "/~2"sv}) {
+            try {
+                Path{bad};
+                assert(false);
+            } catch (const ParsingError&) {
+                // ok
+            }
+        }
+    }
+
+    void TestSaxParse() {
+        const std::string text = R"({"b": [1, 2.5, "x\ty", null], "a": {"t": true, "f": false}, "e": []})"s;
+        // События приходят в порядке документа, без сортировки ключей
+        const std::string expected
+            = "{ key:b [ int:1 double:2.5 str:x\ty null ] key:a { key:t true key:f false } key:e [ ] } "s;
+
+        RecordingHandler from_buffer;
+        json::Parse(text, from_buffer);
+        assert(from_buffer.GetEvents() == expected);
+
+        RecordingHandler from_stream;
+        std::istringstream strm(text);
+        json::Parse(strm, from_stream);
+        assert(from_stream.GetEvents() == expected);
+
+        // Большие целые приходят точно, как и в дереве Node
+        RecordingHandler numbers;
+        json::Parse("[4294967296, 9223372036854775807, 18446744073709551615]"sv, numbers);
+        assert(numbers.GetEvents() == "[ int64:4294967296 int64:9223372036854775807 uint64:18446744073709551615 ] "s);
+
+        RecordingHandler failed;
+        try {
+            json::Parse(R"({"a": [1, })"sv, failed);
+            assert(false);
+        } catch (const json::ParsingError&) {
+            // ok
+        }
+    }
+
+    // Токены, попадающие на границу блоков потокового чтения
+    void TestStreamingChunkBoundaries() {
+        std::string body = "["s;
+        const std::string items[] = {
+            R"("long string with \"escapes\" and \\ backslashes")"s, "1234567"s, "-1.5e+30"s, "true"s, "false"s,
+            "null"s, R"({"key": "value", "n": 0.125})"s, "[]"s,
+        };
+        for (size_t i = 0; body.size() < 70'000; ++i) {
+            body += items[i % std::size(items)];
+            body += ",\n  "s;
+        }
+        body += "0]"s;
+
+        const Node expected = json::Load(std::string_view(body)).GetRoot();
+        for (size_t padding = 0; padding < 64; ++padding) {
+            const std::string text = std::string(padding, ' ') + body;
+            std::istringstream strm(text);
+            assert(json::Load(strm).GetRoot() == expected);
+        }
+    }
+
+    // Разбор входа, поданного частями любого размера
+    void TestPushParser() {
+        const std::string text = R"( {"s": "long string with \"escapes\" and \\ slashes", "n": [0, -12, 4294967296,
+            18446744073709551615, -1.5e+30, 0.125], "l": [true, false, null], "e": [], "d": {}, "k\"ey": {"x": "y"}} )"s;
+        const Document expected = json::Load(text);
+        RecordingHandler expected_events;
+        json::Parse(text, expected_events);
+
+        for (size_t chunk = 1; chunk <= text.size(); ++chunk) {
+            PushParser parser;
+            RecordingHandler events;
+            PushParser sax(events);
+            for (size_t pos = 0; pos < text.size(); pos += chunk) {
+                parser.Feed(std::string_view(text).substr(pos, chunk));
+                sax.Feed(std::string_view(text).substr(pos, chunk));
+            }
+            parser.Finish();
+            sax.Finish();
+            assert(parser.TakeDocument() == expected);
+            assert(events.GetEvents() == expected_events.GetEvents());
+        }
+
+        // Значение верхнего уровня, которое завершает только конец входа
+        const auto push = [](std::initializer_list<std::string_view> chunks, const LoadOptions& options = {}) {
+            PushParser parser(options);
+            for (std::string_view chunk : chunks) {
+                parser.Feed(chunk);
+            }
+            parser.Finish();
+            return parser.TakeDocument();
+        };
+        assert(push({"4"sv, "2"sv}).GetRoot().AsInt() == 42);
+        assert(push({"tr"sv, "ue"sv, ""sv}).GetRoot().AsBool());
+        assert(push({"\"a\\"sv, "nb\""sv}).GetRoot().AsString() == "a\nb"sv);
+
+        const Document arena = push({"[[1, 2], "sv, "[1, 2]]"sv}, LoadOptions{.use_arena = true});
+        assert(arena.HasArena() && arena.GetRoot() == json::Load("[[1, 2], [1, 2]]"sv).GetRoot());
+        const Document shared = push({"[[1, 2], "sv, "[1, 2]]"sv}, LoadOptions{.deduplicate = true});
+        assert(&shared.GetRoot().AsArray()[0].AsArray() == &shared.GetRoot().AsArray()[1].AsArray());
+
+        const std::vector<std::vector<std::string_view>> broken{
+            {""sv},          {"[1, 2"sv},   {"[1, 2]"sv, " 3"sv}, {"tr"sv, "ux"sv}, {"1."sv},
+            {"\"abc"sv},     {"[1 2]"sv},   {"{1: 2}"sv},         {"{\"a\" 1}"sv}, {"[1,]"sv},
+            {"\"\\"sv, "q\""sv}, {"-"sv, "x"sv}, {"01"sv},
+        };
+        for (const auto& chunks : broken) {
+            try {
+                PushParser parser;
+                for (std::string_view chunk : chunks) {
+                    parser.Feed(chunk);
+                }
+                parser.Finish();
+                assert(false);
+            } catch (const ParsingError&) {
+                // ok
+            }
+        }
+
+        RecordingHandler events;
+        PushParser sax(events);
+        sax.Feed("[1]"sv);
+        sax.Finish();
+        try {
+            sax.TakeDocument();
+            assert(false);
+        } catch (const std::logic_error&) {
+            // ok
+        }
+    }
+
+    void TestArrayReader() {
+        const Array records = MakeRecords(100);
+        std::istringstream strm(Print(Node{records}));
+        ArrayReader reader(strm);
+        size_t count = 0;
+        for (const Node& record : reader) {
+            assert(record == records.at(count));
+            ++count;
+        }
+        assert(count == records.size());
+        assert(!reader.Next());
+
+        std::istringstream mixed(R"( [1, "two", [3], {"four": 4}, null] )"s);
+        ArrayReader mixed_reader(mixed);
+        assert(mixed_reader.Next() == Node{1});
+        assert(mixed_reader.Next() == Node{"two"s});
+        assert(*mixed_reader.begin() == (Node{Array{3}}));
+        assert(mixed_reader.Next() == (Node{Dict{{"four"s, 4}}}));
+        assert(mixed_reader.Next() == Node{});
+        assert(!mixed_reader.Next());
+
+        std::istringstream empty(" [ ] "s);
+        ArrayReader empty_reader(empty);
+        assert(empty_reader.begin() == empty_reader.end());
+
+        std::istringstream not_array(R"({"key": 1})"s);
+        try {
+            ArrayReader failed(not_array);
+            assert(false);
+        } catch (const ParsingError&) {
+            // ok
+        }
+
+        // Ошибка в середине массива обнаруживается при чтении испорченного элемента
+        std::istringstream broken("[1, 2, tru, 4]"s);
+        ArrayReader broken_reader(broken);
+        assert(broken_reader.Next() == Node{1});
+        assert(broken_reader.Next() == Node{2});
+        try {
+            broken_reader.Next();
+            assert(false);
+        } catch (const ParsingError&) {
+            // ok
+        }
+    }
+
+    void TestPrintCompact() {
+        const Node node{Dict{{"a"s, Array{1, "x\ny"s, Array{}}}, {"b"s, Dict{}}, {"c"s, nullptr}}};
+        std::ostringstream out;
+        PrintCompact(Document{node}, out);
+        assert(out.str() == R"({"a":[1,"x\ny",[]],"b":{},"c":null})"s);
+        assert(LoadJSON(out.str()).GetRoot() == node);
+    }
+
+    void TestWriter() {
+        const Node node{Dict{{"a"s, Array{1, 2.5, "x\"y"s}}, {"b"s, Dict{{"c"s, true}}}}};
+
+        std::ostringstream pretty;
+        {
+            WriterOptions options;
+            options.indent = 2;
+            Writer writer(pretty, options);
+            writer.Write(node);
+        }
+        assert(pretty.str() == "{\n  \"a\": [\n    1,\n    2.5,\n    \"x\\\"y\"\n  ],\n  \"b\": {\n    \"c\": true\n  }\n}"s);
+
+        // Значения можно передавать по одному, минуя дерево Node
+        std::ostringstream compact;
+        {
+            WriterOptions options;
+            options.compact = true;
+            Writer writer(compact, options);
+            writer.StartObject();
+            writer.Key("a"sv);
+            writer.StartArray();
+            writer.Int(1);
+            writer.Double(2.5);
+            writer.String("x\"y"sv);
+            writer.EndArray();
+            writer.Key("b"sv);
+            writer.StartObject();
+            writer.Key("c"sv);
+            writer.Bool(true);
+            writer.EndObject();
+            writer.EndObject();
+            // До Flush данные остаются в буфере
+            assert(compact.str().empty());
+            writer.Flush();
+            assert(compact.str() == R"({"a":[1,2.5,"x\"y"],"b":{"c":true}})"s);
+        }
+
+        // Строки длиннее буфера и экранирование на его границах
+        std::string long_str;
+        for (int i = 0; long_str.size() < 1000; ++i) {
+            long_str += "chunk\t"s + std::to_string(i) + "\\\n\""s;
+        }
+        const Node long_node{Array{long_str, Node{int64_t{-5'000'000'000}}, Node{UINT64_MAX}, long_str}};
+        std::ostringstream small_buffer;
+        {
+            WriterOptions options;
+            options.buffer_size = 64;
+            Writer writer(small_buffer, options);
+            writer.Write(long_node);
+        }
+        assert(LoadJSON(small_buffer.str()).GetRoot() == long_node);
+        assert(small_buffer.str() == Print(long_node));
+    }
+
+    void TestBuilder() {
+        std::ostringstream out;
+        Builder builder(out);
+        builder.StartArray()
+            .Value(1)
+            .StartDict()
+            .Key("big"sv)
+            .Value(UINT64_MAX)
+            .Key("list"sv)
+            .StartArray()
+            .EndArray()
+            .Key("s"sv)
+            .Value("text")
+            .EndDict()
+            .Value(Node{Dict{{"k"s, nullptr}}})
+            .Value(2.5)
+            .EndArray()
+            .Finish();
+        const Node expected{Array{1, Dict{{"s"s, "text"s}, {"list"s, Array{}}, {"big"s, UINT64_MAX}},
+                                  Dict{{"k"s, nullptr}}, 2.5}};
+        assert(out.str() == Print(expected));
+
+#ifndef NDEBUG
+        // Неправильная последовательность вызовов обнаруживается в отладочной сборке
+        std::ostringstream sink;
+        MustThrowLogicError([&sink] {
+            Builder(sink).StartDict().Value(1);
+        });
+        MustThrowLogicError([&sink] {
+            Builder(sink).StartDict().Key("a"sv).Key("b"sv);
+        });
+        MustThrowLogicError([&sink] {
+            Builder(sink).StartArray().Key("a"sv);
+        });
+        MustThrowLogicError([&sink] {
+            Builder(sink).StartArray().EndDict();
+        });
+        MustThrowLogicError([&sink] {
+            Builder(sink).Value(1).Value(2);
+        });
+        MustThrowLogicError([&sink] {
+            Builder(sink).StartDict().Key("a"sv).EndDict();
+        });
+        MustThrowLogicError([&sink] {
+            Builder(sink).StartArray().Finish();
+        });
+        MustThrowLogicError([&sink] {
+            Builder(sink).Finish();
+        });
+#endif
+    }
+
+    NdjsonOptions MakeNdjsonOptions(unsigned threads, size_t batch_bytes) {
+        NdjsonOptions options;
+        options.threads = threads;
+        options.batch_bytes = batch_bytes;
+        return options;
+    }
+
+    // Поток, отдающий текст и затем бросающий исключение при чтении
+    class FailingBuf : public std::streambuf {
+    public:
+        explicit FailingBuf(std::string text)
+            : text_(std::move(text)) {
+            setg(text_.data(), text_.data(), text_.data() + text_.size());
+        }
+
+    protected:
+        int_type underflow() override {
+            throw std::runtime_error("read failed");
+        }
+
+    private:
+        std::string text_;
+    };
+
+    void TestNdjson() {
+        std::vector<Node> nodes;
+        for (int i = 0; i < 1'000; ++i) {
+            nodes.push_back(i % 3 == 0 ? Node{i} : i % 3 == 1 ? Node{"line\n"s + std::to_string(i)} : Node{MakeRecords(1)});
+        }
+        std::stringstream strm;
+        NdjsonWriter writer(strm);
+        for (const Node& node : nodes) {
+            writer.Write(Document{node});
+        }
+        writer.Flush();
+        const std::string text = strm.str();
+        assert(static_cast<size_t>(std::count(text.begin(), text.end(), '\n')) == nodes.size());
+
+        // Маленькие пакеты, чтобы строки распределялись по многим потокам
+        for (const unsigned threads : {1u, 4u}) {
+            std::istringstream input(text);
+            NdjsonReader reader(input, MakeNdjsonOptions(threads, 256));
+            size_t count = 0;
+            while (auto doc = reader.Next()) {
+                assert(doc->GetRoot() == nodes.at(count));
+                ++count;
+            }
+            assert(count == nodes.size());
+        }
+
+        // Пустые строки и CRLF допустимы, последняя строка может не заканчиваться переводом строки
+        std::istringstream crlf("1\r\n\r\n  \n\"two\"\r\n[3]"s);
+        NdjsonReader crlf_reader(crlf);
+        assert(crlf_reader.Next()->GetRoot() == Node{1});
+        assert(crlf_reader.Next()->GetRoot() == Node{"two"s});
+        assert(crlf_reader.Next()->GetRoot() == (Node{Array{3}}));
+        assert(!crlf_reader.Next());
+
+        // Ошибка выдаётся в порядке следования строк
+        std::istringstream broken("1\n2\n3 4\n5\n"s);
+        NdjsonReader broken_reader(broken, MakeNdjsonOptions(2, 2));
+        assert(broken_reader.Next()->GetRoot() == Node{1});
+        assert(broken_reader.Next()->GetRoot() == Node{2});
+        try {
+            broken_reader.Next();
+            assert(false);
+        } catch (const ParsingError&) {
+            // ok
+        }
+        assert(!broken_reader.Next());
+
+        // Ошибка чтения не теряет документы из уже прочитанных пакетов
+        for (const unsigned threads : {1u, 4u}) {
+            FailingBuf failing_buf("1\n2\n3\n"s);
+            std::istream failing(&failing_buf);
+            failing.exceptions(std::ios::badbit);
+            NdjsonReader failing_reader(failing, MakeNdjsonOptions(threads, 2));
+            for (int i = 1; i <= 3; ++i) {
+                assert(failing_reader.Next()->GetRoot() == Node{i});
+            }
+            try {
+                failing_reader.Next();
+                assert(false);
+            } catch (const std::runtime_error&) {
+                // ok
+            }
+            assert(!failing_reader.Next());
+        }
+
+        // Читатель можно разрушить, не дочитав вход
+        std::istringstream partial(text);
+        NdjsonReader partial_reader(partial, MakeNdjsonOptions(2, 64));
+        assert(partial_reader.Next()->GetRoot() == nodes.front());
+    }
+
+    void TestLoadParallel() {
+        const std::string texts[] = {
+            Print(Node{MakeRecords(50)}),
+            R"({"b": [1, [2, {"c": "]}[{,:\""}], {}, []], "a": {"x": [ ], "y": { }}, "b": "dup", "e": -1.5})"s,
+            R"( [ "[", "]", "{\"}", 0, true, null, [[[]]], {"k": [1, 2, 3]} ] )"s,
+            "[]"s,
+            " {} "s,
+            "42"s,
+            R"("text")"s,
+            R"([1, 2] {"trailing data is ignored like in Load")"s,
+        };
+        for (const std::string& text : texts) {
+            const Document expected = json::Load(text);
+            for (const unsigned threads : {1u, 3u}) {
+                // Порог в один байт заставляет делить даже маленькие массивы
+                const ParallelLoadOptions options{.threads = threads, .min_parallel_bytes = 1};
+                assert(LoadParallel(text, options) == expected);
+            }
+            assert(LoadParallel(text) == expected);
+        }
+
+        // Крупные контейнеры внутри элементов массива разбираются рекурсивно
+        const std::string records = Print(Node{MakeRecords(200)});
+        for (const std::string& wrapped : {"["s + records + "]"s, R"([1, {"data": )"s + records + R"(}, "tail"])"s,
+                                           "[["s + records + ", "s + records + "], 2]"s}) {
+            assert(LoadParallel(wrapped, ParallelLoadOptions{.threads = 4, .min_parallel_bytes = 1024}) == LoadJSON(wrapped));
+        }
+
+        // Большой словарь с ключами по убыванию сортируется один раз
+        const std::string reversed = MakeReversedKeys(100'000);
+        assert(LoadParallel(reversed, ParallelLoadOptions{.threads = 4, .min_parallel_bytes = 1024}) == LoadJSON(reversed));
+
+        for (const std::string_view broken : {"[1, 2"sv, "[1 2]"sv, R"({"a" 1})"sv, "[1,]"sv, R"(["a])"sv, "{]"sv,
+                                               "[1, tru]"sv, R"({"a": 1,})"sv, R"({1: 2})"sv, "[1, 2}"sv}) {
+            try {
+                LoadParallel(broken, ParallelLoadOptions{.threads = 2, .min_parallel_bytes = 1});
+                std::cerr << "ParsingError exception is expected on '"sv << broken << "'"sv << std::endl;
+                assert(false);
+            } catch (const ParsingError&) {
+                // ok
+            }
+        }
+
+        // Данные после крупного вложенного контейнера до разделителя и ошибка рядом с ним
+        std::string ints = "[0"s;
+        for (int i = 1; i < 20000; ++i) {
+            ints += ", "s + std::to_string(i);
+        }
+        ints += "]"s;
+        for (const std::string& broken : {R"({"a": )"s + ints + R"( 5, "b": 1})"s, R"({"a": )"s + ints + " true}"s,
+                                          "["s + ints + " null, 1]"s, "[["s + ints + "], [1 2]]"s}) {
+            MustFailToLoad(broken);
+            try {
+                LoadParallel(broken, ParallelLoadOptions{.threads = 4, .min_parallel_bytes = 1024});
+                std::cerr << "ParsingError exception is expected on a large nested container"sv << std::endl;
+                assert(false);
+            } catch (const ParsingError&) {
+                // ok
+            }
+        }
+    }
+
     void TestErrorHandling() {
         MustFailToLoad("["s);
         MustFailToLoad("]"s);
@@ -234,29 +1558,744 @@ namespace {
 
     void Benchmark() {
         const auto start = std::chrono::steady_clock::now();
-        Array arr;
-        arr.reserve(1'000);
-        for (int i = 0; i < 1'000; ++i) {
-            arr.emplace_back(Dict{
-                {"int"s, 42},
-                {"double"s, 42.1},
-                {"null"s, nullptr},
-                {"string"s, "hello"s},
-                {"array"s, Array{1, 2, 3}},
-                {"bool"s, true},
-                {"map"s, Dict{{"key"s, "value"s}}},
-            });
-        }
+        const Document original{MakeRecords(1'000)};
         std::stringstream strm;
-        json::Print(Document{arr}, strm);
+        json::Print(original, strm);
         const auto doc = json::Load(strm); //error
-        assert(doc.GetRoot() == arr);
+        assert(doc == original);
         const auto duration = std::chrono::steady_clock::now() - start;
         std::cout << std::chrono::duration_cast<std::chrono::milliseconds>(duration).count() << "ms"sv
                   << std::endl;
     }
 
-    
+    template <typename Fn>
+    long long MeasureMs(int repeats, Fn fn) {
+        const auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < repeats; ++i) {
+            fn();
+        }
+        const auto duration = std::chrono::steady_clock::now() - start;
+        return std::chrono::duration_cast<std::chrono::milliseconds>(duration).count();
+    }
+
+    // Скорость записи в обычном и компактном виде
+    void BenchmarkWriter() {
+        const Document doc{MakeRecords(100'000)};
+        size_t pretty_size = 0;
+        size_t compact_size = 0;
+        const auto pretty_ms = MeasureMs(5, [&doc, &pretty_size] {
+            std::ostringstream out;
+            json::Print(doc, out);
+            pretty_size = out.str().size();
+        });
+        const auto compact_ms = MeasureMs(5, [&doc, &compact_size] {
+            std::ostringstream out;
+            json::PrintCompact(doc, out);
+            compact_size = out.str().size();
+        });
+        std::cout << "100000 records x5: Print "sv << pretty_ms << "ms ("sv << pretty_size / 1024 << "KiB), PrintCompact "sv
+                  << compact_ms << "ms ("sv << compact_size / 1024 << "KiB)"sv << std::endl;
+    }
+
+    // Поток, только подсчитывающий записанные байты
+    class CountingBuf : public std::streambuf {
+    public:
+        size_t GetSize() const { return size_; }
+
+    protected:
+        std::streamsize xsputn(const char*, std::streamsize count) override {
+            size_ += static_cast<size_t>(count);
+            return count;
+        }
+        int_type overflow(int_type ch) override {
+            ++size_;
+            return ch;
+        }
+
+    private:
+        size_t size_ = 0;
+    };
+
+    // Запись больших массивов записей через дерево Node и через Builder
+    void BenchmarkBuilder() {
+        auto emit_record = [](Builder& builder, int i) {
+            builder.StartDict()
+                .Key("array"sv).StartArray().Value(1).Value(2).Value(3).EndArray()
+                .Key("bool"sv).Value(true)
+                .Key("double"sv).Value(42.1)
+                .Key("int"sv).Value(i)
+                .Key("map"sv).StartDict().Key("key"sv).Value("value").EndDict()
+                .Key("null"sv).Value(nullptr)
+                .Key("string"sv).Value("hello")
+                .EndDict();
+        };
+
+        {
+            const size_t count_before = allocation_count;
+            const size_t bytes_before = allocated_bytes;
+            CountingBuf buf;
+            std::ostream out(&buf);
+            const auto ms = MeasureMs(1, [&out] {
+                json::PrintCompact(Document{MakeRecords(100'000)}, out);
+            });
+            std::cout << "100000 records: Node tree + PrintCompact "sv << ms << "ms, "sv
+                      << allocation_count - count_before << " allocations, "sv
+                      << (allocated_bytes - bytes_before) / 1024 << "KiB allocated"sv << std::endl;
+        }
+        for (const int records : {100'000, 1'000'000}) {
+            const size_t count_before = allocation_count;
+            const size_t bytes_before = allocated_bytes;
+            CountingBuf buf;
+            std::ostream out(&buf);
+            const auto ms = MeasureMs(1, [&out, &emit_record, records] {
+                WriterOptions options;
+                options.compact = true;
+                Builder builder(out, options);
+                builder.StartArray();
+                for (int i = 0; i < records; ++i) {
+                    emit_record(builder, i);
+                }
+                builder.EndArray().Finish();
+            });
+            std::cout << records << " records: Builder "sv << ms << "ms, "sv << allocation_count - count_before
+                      << " allocations, "sv << (allocated_bytes - bytes_before) / 1024 << "KiB allocated, "sv
+                      << buf.GetSize() / 1024 << "KiB written"sv << std::endl;
+        }
+    }
+
+    // Поиск ключей и построение словарей: Dict против std::map
+    void BenchmarkDict() {
+        using MapDict = std::pmr::map<std::string, Node>;
+        const std::string keys[] = {"array"s, "bool"s, "double"s, "int"s, "map"s, "null"s, "string"s};
+        constexpr int count = 100'000;
+
+        std::vector<MapDict> maps(count);
+        std::vector<Dict> dicts(count);
+        const auto map_build_ms = MeasureMs(1, [&] {
+            for (MapDict& map : maps) {
+                for (const std::string& key : keys) {
+                    map.insert_or_assign(key, Node{1});
+                }
+            }
+        });
+        const auto dict_build_ms = MeasureMs(1, [&] {
+            for (Dict& dict : dicts) {
+                for (const std::string& key : keys) {
+                    dict.insert_or_assign(key, Node{1});
+                }
+            }
+        });
+
+        int sum = 0;
+        const auto map_find_ms = MeasureMs(10, [&] {
+            for (const MapDict& map : maps) {
+                for (const std::string& key : keys) {
+                    sum += map.at(key).AsInt();
+                }
+            }
+        });
+        const auto dict_find_ms = MeasureMs(10, [&] {
+            for (const Dict& dict : dicts) {
+                for (const std::string& key : keys) {
+                    sum += dict.at(key).AsInt();
+                }
+            }
+        });
+        const std::vector<Key> handles(std::begin(keys), std::end(keys));
+        const auto key_find_ms = MeasureMs(10, [&] {
+            for (const Dict& dict : dicts) {
+                for (const Key& key : handles) {
+                    sum += dict.at(key).AsInt();
+                }
+            }
+        });
+        assert(sum == 3 * 10 * count * 7);
+        std::cout << "100000 dicts x7 keys: build std::map "sv << map_build_ms << "ms, Dict "sv << dict_build_ms
+                  << "ms; lookup x10 std::map "sv << map_find_ms << "ms, Dict "sv << dict_find_ms << "ms, Key "sv
+                  << key_find_ms << "ms"sv << std::endl;
+    }
+
+    // Загрузка записей с длинными строками с копированием и без
+    void BenchmarkBorrowedStrings() {
+        std::string text = "["s;
+        for (int i = 0; i < 100'000; ++i) {
+            text += i == 0 ? ""sv : ","sv;
+            text += R"({"name": "a string value longer than fifteen chars", "note": "another moderately long string"})"sv;
+        }
+        text += "]"sv;
+
+        for (const bool borrow : {false, true}) {
+            const size_t count_before = allocation_count;
+            const size_t bytes_before = allocated_bytes;
+            const auto ms = MeasureMs(1, [&text, borrow] {
+                json::Load(text, LoadOptions{.borrow_strings = borrow});
+            });
+            std::cout << "100000 records x2 long strings, "sv << (borrow ? "borrowed"sv : "copied"sv) << ": Load "sv
+                      << ms << "ms, "sv << allocation_count - count_before << " allocations, "sv
+                      << (allocated_bytes - bytes_before) / 1024 << "KiB allocated"sv << std::endl;
+        }
+    }
+
+    // Память и время загрузки записей с длинными повторяющимися ключами
+    void BenchmarkLongKeys() {
+        std::string text = "["s;
+        for (int i = 0; i < 100'000; ++i) {
+            text += i == 0 ? ""sv : ","sv;
+            text += R"({"customer_identifier": 1, "transaction_timestamp": 2, "settlement_currency_code": "EUR"})"sv;
+        }
+        text += "]"sv;
+
+        const size_t count_before = allocation_count;
+        const size_t bytes_before = allocated_bytes;
+        std::optional<Document> doc;
+        const auto ms = MeasureMs(1, [&text, &doc] {
+            doc = json::Load(std::string_view(text));
+        });
+        std::cout << "100000 records x3 long keys: Load "sv << ms << "ms, "sv << allocation_count - count_before
+                  << " allocations, "sv << (allocated_bytes - bytes_before) / 1024 << "KiB allocated"sv << std::endl;
+    }
+
+    // Сравнение разбора из istream и из непрерывного буфера
+    void BenchmarkLoad() {
+        for (const auto& [records, repeats] : {std::pair{1'000, 20}, std::pair{100'000, 1}}) {
+            std::ostringstream out;
+            json::Print(Document{MakeRecords(records)}, out);
+            const std::string text = out.str();
+
+            const auto stream_ms = MeasureMs(repeats, [&text] {
+                std::istringstream strm(text);
+                json::Load(strm);
+            });
+            const auto view_ms = MeasureMs(repeats, [&text] {
+                json::Load(std::string_view(text));
+            });
+            std::cout << records << " records x"sv << repeats << ": Load(istream) "sv << stream_ms
+                      << "ms, Load(string_view) "sv << view_ms << "ms"sv << std::endl;
+        }
+    }
+
+    // Загрузка файла через ifstream и через отображение в память
+    void BenchmarkLoadFile() {
+        std::ostringstream out;
+        json::Print(Document{MakeRecords(200'000)}, out);
+        const std::filesystem::path path = WriteTempFile("json_load_file_bench.json", out.str());
+
+        const auto stream_ms = MeasureMs(3, [&path] {
+            std::ifstream input(path, std::ios::binary);
+            json::Load(input);
+        });
+        const auto read_ms = MeasureMs(3, [&path] {
+            std::ifstream input(path, std::ios::binary);
+            std::string text(std::filesystem::file_size(path), '\0');
+            input.read(text.data(), static_cast<std::streamsize>(text.size()));
+            LoadBuffer(std::move(text));
+        });
+        const auto mapped_ms = MeasureMs(3, [&path] {
+            LoadFile(path);
+        });
+        std::cout << "200000 records file ("sv << std::filesystem::file_size(path) / (1 << 20)
+                  << "MiB) x3: Load(ifstream) "sv << stream_ms << "ms, read + LoadBuffer "sv << read_ms
+                  << "ms, LoadFile "sv << mapped_ms << "ms"sv << std::endl;
+        std::filesystem::remove(path);
+    }
+
+    // Повторная загрузка одного документа: текст против двоичного формата
+    void BenchmarkBinary() {
+        const Document source{MakeRecords(200'000)};
+        std::ostringstream text_out;
+        json::Print(source, text_out);
+        const std::string text = text_out.str();
+        std::ostringstream binary_out;
+        SaveBinary(source, binary_out);
+        const std::string binary = binary_out.str();
+
+        const auto text_ms = MeasureMs(3, [&text] {
+            json::Load(text);
+        });
+        const auto binary_ms = MeasureMs(3, [&binary] {
+            LoadBinary(binary);
+        });
+        const auto borrowed_ms = MeasureMs(3, [&binary] {
+            LoadBinary(binary, LoadOptions{.use_arena = true, .borrow_strings = true});
+        });
+        const auto save_ms = MeasureMs(3, [&source] {
+            std::ostringstream out;
+            SaveBinary(source, out);
+        });
+        assert(LoadBinary(binary).GetRoot() == source.GetRoot());
+        std::cout << "200000 records x3: text "sv << text.size() / 1024 << "KiB, binary "sv << binary.size() / 1024
+                  << "KiB; Load "sv << text_ms << "ms, LoadBinary "sv << binary_ms
+                  << "ms, LoadBinary arena + borrowed "sv << borrowed_ms << "ms, SaveBinary "sv << save_ms << "ms"sv
+                  << std::endl;
+    }
+
+    // Время до первого обращения и проход по всем записям: снимок против загрузки
+    void BenchmarkSnapshot() {
+        const Document source{MakeRecords(200'000)};
+        const std::filesystem::path text_path = std::filesystem::temp_directory_path() / "json_snapshot_bench.json";
+        {
+            std::ofstream out(text_path, std::ios::binary);
+            json::Print(source, out);
+        }
+        const std::filesystem::path binary_path = std::filesystem::temp_directory_path() / "json_snapshot_bench.jsnb";
+        {
+            std::ofstream out(binary_path, std::ios::binary);
+            SaveBinary(source, out);
+        }
+        const std::filesystem::path path = std::filesystem::temp_directory_path() / "json_snapshot_bench.jsns";
+        Snapshot::Save(source, path);
+
+        const auto start = std::chrono::steady_clock::now();
+        const Snapshot snapshot = Snapshot::Open(path);
+        const int first = snapshot.GetRoot().AsArray()[0].AsMap().at("int"sv).AsInt();
+        const auto open_us
+            = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+        assert(first == 42);
+
+        int64_t snapshot_sum = 0;
+        const auto scan_ms = MeasureMs(1, [&snapshot, &snapshot_sum] {
+            for (const SnapshotNode record : snapshot.GetRoot().AsArray()) {
+                snapshot_sum += record.AsMap().at("array"sv).AsArray()[2].AsInt();
+            }
+        });
+        const auto text_ms = MeasureMs(1, [&text_path] {
+            LoadFile(text_path);
+        });
+        const auto binary_ms = MeasureMs(1, [&binary_path] {
+            LoadBinaryFile(binary_path);
+        });
+        assert(snapshot_sum == 3 * 200'000);
+        std::cout << "200000 records: Snapshot ("sv << snapshot.GetSize() / (1 << 20) << "MiB) open + first field "sv
+                  << open_us << "us, scan all "sv << scan_ms << "ms; LoadFile "sv << text_ms << "ms, LoadBinaryFile "sv
+                  << binary_ms << "ms"sv << std::endl;
+        std::filesystem::remove(text_path);
+        std::filesystem::remove(binary_path);
+        std::filesystem::remove(path);
+    }
+
+    // Сравнение больших деревьев, различающихся в последней записи, и поиск дубликатов
+    void BenchmarkHash() {
+        const Document original = json::Load(Print(Node{MakeRecords(200'000)}));
+        Array changed_records = MakeRecords(200'000);
+        changed_records.back() = Dict{{"int"s, 43}};
+        const Document changed{std::move(changed_records)};
+
+        bool equal = true;
+        const auto walk_ms = MeasureMs(1, [&] {
+            equal = original.GetRoot() == changed.GetRoot();
+        });
+        assert(!equal);
+        const auto hash_ms = MeasureMs(1, [&] {
+            original.GetRoot().Hash();
+            changed.GetRoot().Hash();
+        });
+        const auto start = std::chrono::steady_clock::now();
+        equal = original.GetRoot() == changed.GetRoot();
+        const auto cached_ns
+            = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+        assert(!equal);
+
+        size_t unique = 0;
+        const auto dedup_ms = MeasureMs(1, [&] {
+            const Array& records = changed.GetRoot().AsArray();
+            unique = std::unordered_set<Node>(records.begin(), records.end()).size();
+        });
+        assert(unique == 2);
+        std::cout << "sizeof(Node) "sv << sizeof(Node) << "; 200000 records differing at the end: == without hashes "sv
+                  << walk_ms << "ms, Hash() of both "sv << hash_ms << "ms, == with cached hashes "sv << cached_ns
+                  << "ns; unordered_set dedup "sv << dedup_ms << "ms"sv << std::endl;
+    }
+
+    // Память на элемент и скорость обхода числовых массивов
+    void BenchmarkNodeSize() {
+        constexpr int kCount = 1'000'000;
+        const auto measure_bytes = [](auto make) {
+            const size_t before = allocated_bytes;
+            const Node node = make();
+            return static_cast<double>(allocated_bytes - before) / kCount;
+        };
+        const double int_bytes = measure_bytes([] {
+            Array array;
+            array.reserve(kCount);
+            for (int i = 0; i < kCount; ++i) {
+                array.emplace_back(i);
+            }
+            return Node{std::move(array)};
+        });
+        const double string_bytes = measure_bytes([] {
+            Array array;
+            array.reserve(kCount);
+            for (int i = 0; i < kCount; ++i) {
+                array.emplace_back("id-"s + std::to_string(i));
+            }
+            return Node{std::move(array)};
+        });
+
+        Array ints;
+        Array doubles;
+        ints.reserve(kCount);
+        doubles.reserve(kCount);
+        for (int i = 0; i < kCount; ++i) {
+            ints.emplace_back(i);
+            doubles.emplace_back(i * 0.5);
+        }
+        int64_t int_sum = 0;
+        const auto int_ms = MeasureMs(10, [&ints, &int_sum] {
+            for (const Node& item : ints) {
+                int_sum += item.AsInt();
+            }
+        });
+        double double_sum = 0;
+        const auto double_ms = MeasureMs(10, [&doubles, &double_sum] {
+            for (const Node& item : doubles) {
+                double_sum += item.AsDouble();
+            }
+        });
+        assert(int_sum > 0 && double_sum > 0);
+        std::cout << "sizeof(Node) "sv << sizeof(Node) << "; 1000000 elements: int "sv << int_bytes
+                  << " bytes each, short string "sv << string_bytes << " bytes each; scan x10: AsInt "sv << int_ms
+                  << "ms, AsDouble "sv << double_ms << "ms"sv << std::endl;
+    }
+
+    // Разделение загруженного документа на записи: копия против переноса
+    void BenchmarkExtract() {
+        const std::string text = Print(Node{MakeRecords(200'000)});
+        Document copied = json::Load(text);
+        Document moved = json::Load(text);
+
+        std::vector<Node> copies;
+        size_t before = allocation_count;
+        const auto copy_ms = MeasureMs(1, [&copied, &copies] {
+            const Array& records = copied.GetRoot().AsArray();
+            copies.assign(records.begin(), records.end());
+        });
+        const size_t copy_allocations = allocation_count - before;
+
+        std::vector<Node> parts;
+        before = allocation_count;
+        const auto move_ms = MeasureMs(1, [&moved, &parts] {
+            Array records = std::move(moved).ExtractRoot().TakeArray();
+            parts.assign(std::make_move_iterator(records.begin()), std::make_move_iterator(records.end()));
+        });
+        const size_t move_allocations = allocation_count - before;
+        assert(parts.size() == copies.size() && parts.back() == copies.back());
+        std::cout << "200000 records split into parts: copy "sv << copy_ms << "ms ("sv << copy_allocations
+                  << " allocations), ExtractRoot + TakeArray "sv << move_ms << "ms ("sv << move_allocations
+                  << " allocations)"sv << std::endl;
+    }
+
+    // Копии общей конфигурации с локальной правкой: глубокая копия против постоянного дерева
+    void BenchmarkPersistent() {
+        Dict config;
+        config.try_emplace("records"s, MakeRecords(10'000));
+        config.try_emplace("server"s, Dict{{"port"s, 8080}});
+        const Document deep{Node{std::move(config)}};
+        Document persistent = deep;
+        Persist(persistent);
+
+        constexpr int kDeepHandlers = 100;
+        constexpr int kPersistentHandlers = 100'000;
+        const auto override_port = [](Document& doc) {
+            doc.GetRoot().AsMutableMap()["server"s].AsMutableMap()["port"s] = 9090;
+        };
+        size_t before = allocation_count;
+        const auto deep_ms = MeasureMs(kDeepHandlers, [&deep, &override_port] {
+            Document copy = deep;
+            override_port(copy);
+        });
+        const size_t deep_allocations = (allocation_count - before) / kDeepHandlers;
+        before = allocation_count;
+        const auto persistent_ms = MeasureMs(kPersistentHandlers, [&persistent, &override_port] {
+            Document copy = persistent;
+            override_port(copy);
+        });
+        const size_t persistent_allocations = (allocation_count - before) / kPersistentHandlers;
+        std::cout << "10000 records config, copy + override per handler: deep "sv
+                  << deep_ms * 1000.0 / kDeepHandlers << "us ("sv << deep_allocations << " allocations), persistent "sv
+                  << persistent_ms * 1000.0 / kPersistentHandlers << "us ("sv << persistent_allocations
+                  << " allocations)"sv << std::endl;
+    }
+
+    // Загрузка документа из одинаковых записей с разделением поддеревьев и без
+    void BenchmarkDeduplicate() {
+        const std::string text = Print(Node{MakeRecords(100'000)});
+        const auto load_ms = MeasureMs(3, [&text] {
+            json::Load(text);
+        });
+        const size_t count_before = allocation_count;
+        const auto dedup_ms = MeasureMs(3, [&text] {
+            json::Load(text, LoadOptions{.deduplicate = true});
+        });
+        const size_t dedup_allocations = (allocation_count - count_before) / 3;
+        Document doc = json::Load(text);
+        size_t saved = 0;
+        const auto compact_ms = MeasureMs(1, [&doc, &saved] {
+            saved = Compact(doc);
+        });
+        std::cout << "100000 identical records x3: Load "sv << load_ms << "ms, Load deduplicate "sv << dedup_ms
+                  << "ms ("sv << dedup_allocations << " allocations per load); Compact "sv << compact_ms
+                  << "ms, saved "sv << saved / 1024 << "KiB"sv << std::endl;
+    }
+
+    // Число обращений к куче при загрузке и разрушении документа
+    void BenchmarkArena() {
+        std::ostringstream out;
+        json::Print(Document{MakeRecords(1'000)}, out);
+        const std::string text = out.str();
+
+        for (const bool use_arena : {false, true}) {
+            const size_t before = allocation_count;
+            const auto ms = MeasureMs(20, [&text, use_arena] {
+                json::Load(text, LoadOptions{.use_arena = use_arena});
+            });
+            std::cout << "1000 records x20, "sv << (use_arena ? "arena"sv : "heap"sv) << ": "sv << ms << "ms, "sv
+                      << (allocation_count - before) / 20 << " allocations per load"sv << std::endl;
+        }
+    }
+
+    // Объём памяти и скорость чтения дерева Node против ленты
+    void BenchmarkTape() {
+        std::ostringstream out;
+        json::Print(Document{MakeRecords(100'000)}, out);
+        const std::string text = out.str();
+
+        const size_t bytes_before = allocated_bytes;
+        const Document doc = json::Load(text);
+        const size_t tree_bytes = allocated_bytes - bytes_before;
+        const TapeDocument tape{doc};
+
+        int tree_sum = 0;
+        const auto tree_ms = MeasureMs(10, [&doc, &tree_sum] {
+            for (const Node& record : doc.GetRoot().AsArray()) {
+                tree_sum += record.AsMap().at("int"s).AsInt() + record.AsMap().at("array"s).AsArray()[2].AsInt();
+            }
+        });
+        int tape_sum = 0;
+        const auto tape_ms = MeasureMs(10, [&tape, &tape_sum] {
+            for (const NodeRef record : tape.GetRoot().AsArray()) {
+                tape_sum += record.AsMap().at("int"sv).AsInt() + record.AsMap().at("array"sv).AsArray()[2].AsInt();
+            }
+        });
+        assert(tree_sum == tape_sum);
+        std::cout << "100000 records: Node tree "sv << tree_bytes / 1024 << "KiB, read x10 "sv << tree_ms
+                  << "ms; tape "sv << tape.GetMemoryUsage() / 1024 << "KiB, read x10 "sv << tape_ms << "ms"sv
+                  << std::endl;
+    }
+
+    // Чтение пары полей в начале большого документа: полная загрузка против ленивой
+    void BenchmarkLazy() {
+        std::ostringstream out;
+        json::Print(Document{Dict{{"header"s, Dict{{"version"s, 3}}}, {"records"s, MakeRecords(100'000)}}}, out);
+        const std::string text = out.str();
+
+        int sum = 0;
+        const auto load_ms = MeasureMs(1, [&text, &sum] {
+            const Document doc = json::Load(text);
+            const Node& root = doc.GetRoot();
+            sum += root.AsMap().at("header"sv).AsMap().at("version"sv).AsInt()
+                + root.AsMap().at("records"sv).AsArray()[0].AsMap().at("int"sv).AsInt();
+        });
+        const auto start = std::chrono::steady_clock::now();
+        const LazyDocument lazy(text);
+        const LazyDict root = lazy.GetRoot().AsMap();
+        sum += root.at("header"sv).AsMap().at("version"sv).AsInt();
+        const auto header_us = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - start).count();
+        sum += root.at("records"sv).AsArray()[0].AsMap().at("int"sv).AsInt();
+        const auto first_us = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - start).count();
+        const auto count_ms = MeasureMs(1, [&root] {
+            [[maybe_unused]] const size_t size = root.at("records"sv).AsArray().size();
+            assert(size == 100'000);
+        });
+        assert(sum == 2 * (3 + 42));
+        std::cout << "100000 records ("sv << text.size() / 1024 << "KiB): Load "sv << load_ms
+                  << "ms; lazy header field "sv << header_us << "us, first record field "sv << first_us
+                  << "us, skip to end "sv << count_ms << "ms"sv << std::endl;
+    }
+
+    // Один и тот же путь по многим записям: цепочка вызовов, готовый Path и разбор пути заново
+    void BenchmarkPath() {
+        const Array records = MakeRecords(100'000);
+        int chain_sum = 0;
+        const auto chain_ms = MeasureMs(10, [&records, &chain_sum] {
+            for (const Node& record : records) {
+                chain_sum += record.AsMap().at("array"sv).AsArray().at(2).AsInt();
+            }
+        });
+        const Path path("/array/2"sv);
+        int path_sum = 0;
+        const auto path_ms = MeasureMs(10, [&records, &path, &path_sum] {
+            for (const Node& record : records) {
+                path_sum += path.Find(record)->AsInt();
+            }
+        });
+        int reparse_sum = 0;
+        const auto reparse_ms = MeasureMs(10, [&records, &reparse_sum] {
+            for (const Node& record : records) {
+                reparse_sum += Path("/array/2"sv).Find(record)->AsInt();
+            }
+        });
+        assert(chain_sum == path_sum && path_sum == reparse_sum);
+
+        std::ostringstream out;
+        json::Print(Document{records}, out);
+        const std::string text = out.str();
+        size_t matches = 0;
+        const auto load_ms = MeasureMs(1, [&text, &matches] {
+            const Document doc = json::Load(text);
+            matches = Path("/*/int"sv).Select(doc.GetRoot()).size();
+        });
+        const auto extract_ms = MeasureMs(1, [&text, &matches] {
+            matches += Path("/*/int"sv).Extract(text).size();
+        });
+        assert(matches == 2 * records.size());
+        std::cout << "100000 records x10: at() chain "sv << chain_ms << "ms, Path "sv << path_ms
+                  << "ms, Path parsed each time "sv << reparse_ms << "ms; /*/int: Load + Select "sv << load_ms
+                  << "ms, Extract "sv << extract_ms << "ms"sv << std::endl;
+    }
+
+    // Время до первой записи и полный проход поэлементным чтением против Load
+    void BenchmarkArrayReader() {
+        std::ostringstream out;
+        json::Print(Document{MakeRecords(100'000)}, out);
+        const std::string text = out.str();
+
+        const auto load_ms = MeasureMs(1, [&text] {
+            std::istringstream strm(text);
+            json::Load(strm);
+        });
+        std::istringstream strm(text);
+        const auto start = std::chrono::steady_clock::now();
+        ArrayReader reader(strm);
+        reader.Next();
+        const auto first_us
+            = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+        size_t count = 1;
+        while (reader.Next()) {
+            ++count;
+        }
+        const auto total_ms
+            = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+        assert(count == 100'000);
+        std::cout << "100000 records: Load "sv << load_ms << "ms; ArrayReader first record "sv << first_us
+                  << "us, all records "sv << total_ms << "ms"sv << std::endl;
+    }
+
+    // Считает записи массива верхнего уровня и запоминает, когда закончилась первая
+    class RecordCounter final : public json::Handler {
+    public:
+        void Null() override {}
+        void Bool(bool) override {}
+        void Int(int) override {}
+        void Int64(int64_t) override {}
+        void Uint64(uint64_t) override {}
+        void Double(double) override {}
+        void String(std::string_view) override {}
+        void StartArray() override { ++depth_; }
+        void EndArray() override { EndValue(); }
+        void StartObject() override { ++depth_; }
+        void Key(std::string_view) override {}
+        void EndObject() override { EndValue(); }
+
+        size_t GetCount() const { return count_; }
+        std::chrono::steady_clock::time_point GetFirstTime() const { return first_; }
+
+    private:
+        void EndValue() {
+            if (--depth_ == 1 && count_++ == 0) {
+                first_ = std::chrono::steady_clock::now();
+            }
+        }
+
+        int depth_ = 0;
+        size_t count_ = 0;
+        std::chrono::steady_clock::time_point first_;
+    };
+
+    // Вход частями по 16 КиБ: накопление и Load против PushParser
+    void BenchmarkPushParser() {
+        const std::string text = Print(Node{MakeRecords(100'000)});
+        constexpr size_t kChunkSize = size_t{16} << 10;
+        const auto since = [](std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end) {
+            return std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+        };
+
+        auto start = std::chrono::steady_clock::now();
+        std::string body;
+        for (size_t pos = 0; pos < text.size(); pos += kChunkSize) {
+            body.append(std::string_view(text).substr(pos, kChunkSize));
+        }
+        const Document buffered = json::Load(body);
+        const auto buffered_us = since(start, std::chrono::steady_clock::now());
+
+        start = std::chrono::steady_clock::now();
+        PushParser parser;
+        for (size_t pos = 0; pos < text.size(); pos += kChunkSize) {
+            parser.Feed(std::string_view(text).substr(pos, kChunkSize));
+        }
+        parser.Finish();
+        const Document pushed = parser.TakeDocument();
+        const auto push_us = since(start, std::chrono::steady_clock::now());
+        assert(pushed == buffered);
+
+        RecordCounter counter;
+        start = std::chrono::steady_clock::now();
+        PushParser sax(counter);
+        for (size_t pos = 0; pos < text.size(); pos += kChunkSize) {
+            sax.Feed(std::string_view(text).substr(pos, kChunkSize));
+        }
+        sax.Finish();
+        const auto sax_us = since(start, std::chrono::steady_clock::now());
+        assert(counter.GetCount() == 100'000);
+        std::cout << "100000 records in 16KiB chunks: buffer + Load "sv << buffered_us / 1000 << "ms; PushParser "sv
+                  << push_us / 1000 << "ms; PushParser SAX "sv << sax_us / 1000 << "ms, first record "sv
+                  << since(start, counter.GetFirstTime()) << "us"sv << std::endl;
+    }
+
+    // Пропускная способность разбора JSON Lines в зависимости от числа потоков
+    void BenchmarkNdjson() {
+        std::ostringstream out;
+        NdjsonWriter writer(out);
+        const Document record{MakeRecords(1).front()};
+        for (int i = 0; i < 200'000; ++i) {
+            writer.Write(record);
+        }
+        writer.Flush();
+        const std::string text = out.str();
+
+        for (const unsigned threads : {1u, 2u, 4u, 8u, 16u}) {
+            size_t count = 0;
+            const auto ms = MeasureMs(1, [&text, &count, threads] {
+                std::istringstream input(text);
+                NdjsonReader reader(input, MakeNdjsonOptions(threads, size_t{1} << 20));
+                while (reader.Next()) {
+                    ++count;
+                }
+            });
+            assert(count == 200'000);
+            std::cout << "NDJSON 200000 lines, "sv << threads << " threads: "sv << ms << "ms"sv << std::endl;
+        }
+    }
+
+    // Масштабирование двухэтапного разбора по числу потоков
+    void BenchmarkLoadParallel() {
+        std::ostringstream out;
+        json::Print(Document{MakeRecords(200'000)}, out);
+        const std::string text = out.str();
+
+        const auto load_ms = MeasureMs(1, [&text] {
+            json::Load(text);
+        });
+        std::cout << "200000 records: Load "sv << load_ms << "ms"sv;
+        for (const unsigned threads : {1u, 2u, 4u, 8u, 16u}) {
+            const auto ms = MeasureMs(1, [&text, threads] {
+                LoadParallel(text, ParallelLoadOptions{.threads = threads});
+            });
+            std::cout << ", "sv << threads << " threads "sv << ms << "ms"sv;
+        }
+        std::cout << std::endl;
+    }
 
 }  // namespace
 
@@ -264,11 +2303,60 @@ int main() {
     
         TestNull();
         TestNumbers();
+        TestInt64();
         TestStrings();
         TestBool();
         TestArray();
         TestMap();
+        TestDictSemantics();
+        TestKeys();
+        TestHash();
+        TestNodeLayout();
+        TestDeduplicate();
+        TestMutableAccess();
+        TestPersistent();
+        TestLoadFromStringView();
+        TestBorrowedStrings();
+        TestLoadFile();
+        TestBinary();
+        TestSnapshot();
+        TestLongStringsAndWhitespace();
+        TestArenaDocument();
+        TestTapeDocument();
+        TestLazyDocument();
+        TestPath();
+        TestSaxParse();
+        TestStreamingChunkBoundaries();
+        TestPushParser();
+        TestArrayReader();
+        TestPrintCompact();
+        TestWriter();
+        TestBuilder();
+        TestNdjson();
+        TestLoadParallel();
         TestErrorHandling();
         Benchmark();
+        BenchmarkLoad();
+        BenchmarkLoadFile();
+        BenchmarkBinary();
+        BenchmarkSnapshot();
+        BenchmarkHash();
+        BenchmarkNodeSize();
+        BenchmarkDeduplicate();
+        BenchmarkExtract();
+        BenchmarkPersistent();
+        BenchmarkDict();
+        BenchmarkLongKeys();
+        BenchmarkBorrowedStrings();
+        BenchmarkWriter();
+        BenchmarkBuilder();
+        BenchmarkArena();
+        BenchmarkTape();
+        BenchmarkLazy();
+        BenchmarkPath();
+        BenchmarkArrayReader();
+        BenchmarkPushParser();
+        BenchmarkNdjson();
+        BenchmarkLoadParallel();
     
 }
\ No newline at end of file